@@ -0,0 +1,188 @@
+/** @internal @file src/kdumpfile/bench-cache.c
+ * @brief Measure cache lookup cost for different cache sizes.
+ */
+/* Copyright (C) 2026 agent <agent@local>
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include "kdumpfile-priv.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_OK     0
+#define TEST_ERR   99
+
+/** Default number of lookups per measurement. */
+#define DEFITER		1000000
+
+/** Smallest measured cache size. */
+#define MIN_SIZE	64
+
+/** Default largest measured cache size. */
+#define DEFMAXSIZE	65536
+
+/** Page size used to make cache keys. */
+#define KEY_SHIFT	12
+
+static unsigned long niter = DEFITER;
+
+static double
+elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1e9 +
+		(end->tv_nsec - start->tv_nsec);
+}
+
+/**  Look up a key, loading it on a miss.
+ * @param cache  Cache object.
+ * @param key    Cache key.
+ * @returns      @c TEST_OK on success, @c TEST_ERR if the cache is full.
+ */
+static int
+lookup(struct cache *cache, cache_key_t key)
+{
+	struct cache_entry *entry;
+
+	entry = cache_get_entry(cache, key);
+	if (!entry)
+		return TEST_ERR;
+	if (!cache_entry_valid(entry)) {
+		*(cache_key_t *)entry->data = key;
+		cache_insert(cache, entry);
+	}
+	cache_put_entry(cache, entry);
+	return TEST_OK;
+}
+
+/**  Measure one cache size.
+ * @param n  Number of cache entries.
+ * @returns  Exit code.
+ */
+static int
+bench_size(unsigned n)
+{
+	struct timespec start, end;
+	struct cache *cache;
+	double hit_ns, miss_ns;
+	unsigned long i;
+
+	cache = cache_alloc(n, n, sizeof(cache_key_t), false);
+	if (!cache) {
+		perror("Cannot allocate cache");
+		return TEST_ERR;
+	}
+
+	for (i = 0; i < n; ++i)
+		if (lookup(cache, i << KEY_SHIFT) != TEST_OK)
+			goto busy;
+
+	/* All keys are cached, so every lookup is a hit. */
+	srand48(n);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < niter; ++i)
+		if (lookup(cache, (lrand48() % n) << KEY_SHIFT) != TEST_OK)
+			goto busy;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	hit_ns = elapsed_ns(&start, &end) / niter;
+
+	/* Keys are never reused, so every lookup is a miss. */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < niter; ++i)
+		if (lookup(cache, (n + i) << KEY_SHIFT) != TEST_OK)
+			goto busy;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	miss_ns = elapsed_ns(&start, &end) / niter;
+
+	cache_free(cache);
+	printf("%8u %12.1f %12.1f\n", n, hit_ns, miss_ns);
+	return TEST_OK;
+
+ busy:
+	fprintf(stderr, "Cache of size %u is fully utilized\n", n);
+	cache_free(cache);
+	return TEST_ERR;
+}
+
+static void
+usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [<options>]\n"
+		"\n"
+		"Options:\n"
+		"  -i iterations   Number of lookups per size (default: %u)\n"
+		"  -m max-size     Largest cache size (default: %u)\n",
+		name, DEFITER, DEFMAXSIZE);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned long maxsize = DEFMAXSIZE;
+	unsigned long n;
+	char *p;
+	int opt;
+	int rc;
+
+	while ((opt = getopt(argc, argv, "hi:m:")) != -1) {
+		switch (opt) {
+		case 'i':
+			niter = strtoul(optarg, &p, 0);
+			if (*p || !niter) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'm':
+			maxsize = strtoul(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'h':
+		default:
+			usage(argv[0]);
+			return (opt == 'h') ? TEST_OK : TEST_ERR;
+		}
+	}
+
+	printf("%8s %12s %12s\n", "entries", "hit (ns)", "miss (ns)");
+	for (n = MIN_SIZE; n <= maxsize; n *= 4) {
+		rc = bench_size(n);
+		if (rc != TEST_OK)
+			return rc;
+	}
+
+	return TEST_OK;
+}
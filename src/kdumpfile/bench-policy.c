@@ -0,0 +1,253 @@
+/** @internal @file src/kdumpfile/bench-policy.c
+ * @brief Compare cache replacement policies on synthetic traces.
+ */
+/* Copyright (C) 2026 agent <agent@local>
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include "kdumpfile-priv.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_OK     0
+#define TEST_ERR   99
+
+/** Default number of lookups per measurement. */
+#define DEFITER		1000000
+
+/** Default number of cache entries. */
+#define DEFCACHE	1024
+
+/** Default number of distinct pages in a trace. */
+#define DEFPAGES	4096
+
+/** Page size used to make cache keys. */
+#define KEY_SHIFT	12
+
+static unsigned long niter = DEFITER;
+static unsigned long cache_size = DEFCACHE;
+static unsigned long npages = DEFPAGES;
+
+/**  Make the n-th page number of a trace.
+ * @param i  Index in the trace.
+ * @returns  Page number.
+ */
+typedef unsigned long trace_fn(unsigned long i);
+
+/**  Uniformly random pages, like multiread without @c -s. */
+static unsigned long
+trace_random(unsigned long i)
+{
+	return lrand48() % npages;
+}
+
+/**  Repeated sequential sweeps over all pages. */
+static unsigned long
+trace_sequential(unsigned long i)
+{
+	return i % npages;
+}
+
+/**  Random hits to a small hot set, interleaved with a long scan.
+ * Every other lookup goes to a hot set of half the cache size, and
+ * the remaining lookups sweep over all pages above the hot set.
+ */
+static unsigned long
+trace_scan(unsigned long i)
+{
+	unsigned long hot = cache_size / 2;
+
+	return (i & 1)
+		? hot + (i / 2) % npages
+		: lrand48() % hot;
+}
+
+static const struct {
+	const char *name;
+	trace_fn *fn;
+} traces[] = {
+	{ "random", trace_random },
+	{ "sequential", trace_sequential },
+	{ "scan", trace_scan },
+};
+
+static const char *const policies[] = {
+	"arc", "fifo", "clock",
+};
+
+static double
+elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1e9 +
+		(end->tv_nsec - start->tv_nsec);
+}
+
+/**  Look up a key, loading it on a miss.
+ * @param cache  Cache object.
+ * @param key    Cache key.
+ * @param hit    Set to @c true on a cache hit.
+ * @returns      @c TEST_OK on success, @c TEST_ERR if the cache is full.
+ */
+static int
+lookup(struct cache *cache, cache_key_t key, bool *hit)
+{
+	struct cache_entry *entry;
+
+	entry = cache_get_entry(cache, key);
+	if (!entry)
+		return TEST_ERR;
+	*hit = cache_entry_valid(entry);
+	if (!*hit) {
+		*(cache_key_t *)entry->data = key;
+		cache_insert(cache, entry);
+	}
+	cache_put_entry(cache, entry);
+	return TEST_OK;
+}
+
+/**  Run one trace with one policy.
+ * @param policy  Policy name.
+ * @param name    Trace name.
+ * @param fn      Trace function.
+ * @returns       Exit code.
+ */
+static int
+bench_policy(const char *policy, const char *name, trace_fn *fn)
+{
+	struct timespec start, end;
+	struct cache *cache;
+	unsigned long i, hits;
+	bool hit;
+
+	cache = cache_alloc(cache_size, cache_size, sizeof(cache_key_t),
+			    false);
+	if (!cache) {
+		perror("Cannot allocate cache");
+		return TEST_ERR;
+	}
+	if (!cache_set_policy(cache, policy)) {
+		fprintf(stderr, "Unknown policy: %s\n", policy);
+		cache_free(cache);
+		return TEST_ERR;
+	}
+
+	srand48(cache_size);
+	hits = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < niter; ++i) {
+		if (lookup(cache, fn(i) << KEY_SHIFT, &hit) != TEST_OK) {
+			fprintf(stderr, "Cache is fully utilized\n");
+			cache_free(cache);
+			return TEST_ERR;
+		}
+		hits += hit;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	cache_free(cache);
+	printf("%-12s %-8s %10.2f %12.1f\n", name, policy,
+	       100.0 * hits / niter, elapsed_ns(&start, &end) / niter);
+	return TEST_OK;
+}
+
+static void
+usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [<options>]\n"
+		"\n"
+		"Options:\n"
+		"  -c entries      Cache size (default: %u)\n"
+		"  -i iterations   Number of lookups per trace (default: %u)\n"
+		"  -n pages        Number of distinct pages (default: %u)\n",
+		name, DEFCACHE, DEFITER, DEFPAGES);
+}
+
+static int
+parse_num(const char *str, unsigned long *num)
+{
+	char *p;
+
+	*num = strtoul(str, &p, 0);
+	if (*p || !*num) {
+		fprintf(stderr, "Invalid number: %s\n", str);
+		return TEST_ERR;
+	}
+	return TEST_OK;
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned i, j;
+	int opt;
+	int rc;
+
+	while ((opt = getopt(argc, argv, "c:hi:n:")) != -1) {
+		switch (opt) {
+		case 'c':
+			if (parse_num(optarg, &cache_size) != TEST_OK)
+				return TEST_ERR;
+			break;
+
+		case 'i':
+			if (parse_num(optarg, &niter) != TEST_OK)
+				return TEST_ERR;
+			break;
+
+		case 'n':
+			if (parse_num(optarg, &npages) != TEST_OK)
+				return TEST_ERR;
+			break;
+
+		case 'h':
+		default:
+			usage(argv[0]);
+			return (opt == 'h') ? TEST_OK : TEST_ERR;
+		}
+	}
+	if (cache_size < 2) {
+		fprintf(stderr, "Cache is too small\n");
+		return TEST_ERR;
+	}
+
+	printf("%-12s %-8s %10s %12s\n",
+	       "trace", "policy", "hits (%)", "lookup (ns)");
+	for (i = 0; i < ARRAY_SIZE(traces); ++i)
+		for (j = 0; j < ARRAY_SIZE(policies); ++j) {
+			rc = bench_policy(policies[j],
+					  traces[i].name, traces[i].fn);
+			if (rc != TEST_OK)
+				return rc;
+		}
+
+	return TEST_OK;
+}
@@ -33,9 +33,12 @@
 #include "kdumpfile-priv.h"
 
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 #include <limits.h>
+#include <time.h>
 
-/**  Simple cache.
+/**  Cache shard.
  *
  * The cache is divided into five sections:
  *   1. probed list: cached entries that have been hit only once
@@ -70,8 +73,39 @@
  * between ghost probed and ghost precious lists. This part of the cache
  * is usually empty; it's used only after a flush or when an entry is
  * discarded.
+ *
+ * Each cache shard implements this scheme independently.
+ *
+ * A shard may grow up to a maximum capacity, which is fixed when the
+ * cache is allocated. The array of entries is allocated for the maximum
+ * capacity, so entry pointers stay valid while the shard grows. Data for
+ * the new entries is allocated in a separate chunk. Until an entry is
+ * needed, its data is kept aside as a spare slot.
+ *
+ * If the cache data is backed by huge pages, the data area is mapped
+ * for the maximum capacity of all shards at once (physical memory is
+ * not used until the data is written), and each shard carves its chunks
+ * from its own part of the mapping.
+ *
+ * All entries except unused ones can also be found by their key in
+ * a hash index (open addressing with linear probing). The index has
+ * at least twice as many slots as there are entries, so a lookup is
+ * fast regardless of the cache size.
+ *
+ * The LRU entry of each list is tracked as well, so the remaining
+ * section boundaries can be found without walking the lists, and
+ * eviction candidates are searched from the LRU end.
+ *
+ * How entries move between the lists on a hit is decided by the
+ * replacement policy of the shard (see @ref cache_policy). Policies
+ * other than the default adaptive one keep all entries on the probe
+ * list, so that a long scan cannot push them to the precious list.
  */
-struct cache {
+struct cache_shard {
+	mutex_t mutex;		 /**< Lock for this shard. */
+	cond_t cond;		 /**< Signalled when an entry is released. */
+	unsigned nwaiters;	 /**< Number of threads waiting on @c cond */
+
 	unsigned split;		 /**< Split point between probed and precious
 				  *   entries (index of MRU probed entry) */
 	unsigned nprec;		 /**< Number of cached precious entries */
@@ -81,22 +115,219 @@ struct cache {
 	unsigned dprobe;	 /**< Desired nubmer of cached probe entries */
 	unsigned nprobetotal;	 /**< Total number of probe list entries,
 				  *   including ghost and in-flight entries */
-	unsigned cap;		 /**< Total cache capacity */
+	unsigned cap;		 /**< Shard capacity */
+	unsigned basecap;	 /**< Initial shard capacity */
+	unsigned maxcap;	 /**< Maximum shard capacity */
+	unsigned nspare;	 /**< Number of spare data slots */
 	unsigned inflight;	 /**< Index of first in-flight entry */
 	unsigned ninflight;	 /**< Number of in-flight entries */
+	unsigned nheld;		 /**< Number of referenced entries */
+
+	unsigned lruprec;	 /**< Index of LRU precious entry */
+	unsigned lrugprec;	 /**< Index of LRU ghost precious entry */
+	unsigned lruprobe;	 /**< Index of LRU probed entry */
+	unsigned lrugprobe;	 /**< Index of LRU ghost probed entry */
+
+	unsigned long hits;	 /**< Cache hits in this shard */
+	unsigned long misses;	 /**< Cache misses in this shard */
+	unsigned long ghost_hits; /**< Misses which hit a ghost entry */
+	unsigned long evictions; /**< Number of evicted entries */
+	unsigned long busy;	 /**< Lookups which failed for a full shard */
+	unsigned inflight_max;	 /**< High-water mark of @c ninflight */
+	unsigned long waits;	 /**< Number of blocking waits */
+	kdump_num_t wait_time;	 /**< Total time spent waiting (in ns) */
+	unsigned long ra_loads;	 /**< Entries got for reading ahead */
+	unsigned long ra_hits;	 /**< First lookups of pages read ahead */
+
+	unsigned adapt_lookups;	 /**< Lookups since last adaptation */
+	unsigned adapt_ghosts;	 /**< Ghost hits since last adaptation */
+
+	unsigned hash_bits;	 /**< Size of the hash index as a power of two */
+	unsigned *hash;		 /**< Hash index (entry indices) */
+	char *pool;		 /**< Next unused data in the shared data
+				  *   area, or @c NULL if not used */
+
+	struct cache *cache;	 /**< Owning cache object */
+	const struct cache_policy *policy; /**< Replacement policy */
+	struct cache_chunk *chunks; /**< Data chunks of this shard */
+	struct cache_entry ce[]; /**< Cache entries */
+};
+
+/**  Cache data chunk.
+ *
+ * Entry data is allocated in chunks, so a shard can grow without moving
+ * the data that is already in use.
+ */
+struct cache_chunk {
+	struct cache_chunk *next; /**< Next chunk in the list */
+	unsigned n;		  /**< Number of elements in this chunk */
+	unsigned nfree;		  /**< Number of elements not yet handed out */
+	void *data;		  /**< Element data */
+};
+
+/**  Maximum number of cache shards (as a power of two). */
+#define CACHE_SHARD_BITS_MAX	4
+
+/**  Minimum number of entries in a cache shard. */
+#define CACHE_SHARD_MIN		64
+
+/**  Ghost hit ratio which makes a shard grow (as a power of two).
+ * If more than 1/2^n lookups hit a ghost entry, the working set is
+ * probably bigger than the shard.
+ */
+#define CACHE_GROW_GHOST_SHIFT	3
+
+/**  Growth step as a fraction of current capacity (as a power of two). */
+#define CACHE_GROW_STEP_SHIFT	2
+
+/**  Minimum size of a hash index (as a power of two). */
+#define CACHE_HASH_BITS_MIN	2
+
+/**  Empty slot in a hash index. */
+#define CACHE_HASH_EMPTY	UINT_MAX
+
+/**  Sharded cache.
+ *
+ * The cache is split into independently locked shards to reduce lock
+ * contention when the same cache is accessed from multiple threads.
+ * Each key is always stored in the same shard, which is selected by
+ * a hash of the key. Small caches are not split at all.
+ */
+struct cache {
+	unsigned shard_bits;	 /**< Number of shards as a power of two */
+	bool wait;		 /**< Wait for busy entries instead of failing */
+	struct data_area pool;	 /**< Shared data area (if @c pool.ptr
+				  *   is not @c NULL) */
 
 	kdump_attr_value_t hits;   /**< Cache hits */
 	kdump_attr_value_t misses; /**< Cache misses */
+	kdump_attr_value_t ghost_hits; /**< Misses which hit a ghost entry */
+	kdump_attr_value_t evictions; /**< Number of evicted entries */
+	kdump_attr_value_t busy;   /**< Lookups which failed for a full shard */
+	kdump_attr_value_t inflight_max; /**< In-flight high-water mark */
+	kdump_attr_value_t waits;  /**< Number of blocking waits */
+	kdump_attr_value_t wait_time; /**< Total wait time (in ns) */
+	kdump_attr_value_t readahead_loads; /**< Pages read ahead */
+	kdump_attr_value_t readahead_hits; /**< Pages read ahead and used */
+	kdump_attr_value_t capacity; /**< Current total capacity */
+	kdump_attr_value_t bytes_used; /**< Size of all data slots */
 
 	size_t elemsize;	 /**< Element data size */
-	void *data;		 /**< Actual cache data */
 
 	/** Cache entry destructor. */
 	cache_entry_cleanup_fn *entry_cleanup;
 	void *cleanup_data;	 /**< User-supplied data for the destructor. */
-	struct cache_entry ce[]; /**< Cache entries */
+	struct cache_shard *shard[]; /**< Cache shards */
 };
 
+/**  Get the number of shards in a cache.
+ * @param cache  Cache object.
+ * @returns      Number of shards.
+ */
+static inline unsigned
+cache_nshards(const struct cache *cache)
+{
+	return 1U << cache->shard_bits;
+}
+
+/**  Get the cache shard for a given key.
+ * @param cache  Cache object.
+ * @param key    Cache entry key.
+ * @returns      The shard which stores @p key.
+ */
+static inline struct cache_shard *
+key_shard(const struct cache *cache, cache_key_t key)
+{
+	return cache->shard_bits
+		? cache->shard[fold_hash(key, cache->shard_bits)]
+		: cache->shard[0];
+}
+
+/**  Get the home slot of a key in the hash index.
+ * @param shard  Cache shard.
+ * @param key    Cache entry key.
+ * @returns      Index of the first slot to be probed.
+ *
+ * The top bits of the hash select the shard, so they are skipped.
+ */
+static inline unsigned
+hash_slot(const struct cache_shard *shard, cache_key_t key)
+{
+	return fold_hash(key, shard->cache->shard_bits + shard->hash_bits) &
+		((1U << shard->hash_bits) - 1);
+}
+
+/**  Find an entry in the hash index.
+ * @param shard  Cache shard (locked).
+ * @param key    Key to be searched.
+ * @returns      Index of the entry, or @ref CACHE_HASH_EMPTY.
+ */
+static unsigned
+hash_find(const struct cache_shard *shard, cache_key_t key)
+{
+	unsigned mask = (1U << shard->hash_bits) - 1;
+	unsigned slot = hash_slot(shard, key);
+	unsigned idx;
+
+	while ((idx = shard->hash[slot]) != CACHE_HASH_EMPTY) {
+		if (shard->ce[idx].key == key)
+			break;
+		slot = (slot + 1) & mask;
+	}
+	return idx;
+}
+
+/**  Add an entry to the hash index.
+ * @param shard  Cache shard (locked).
+ * @param idx    Index of an entry which is not in the hash index.
+ */
+static void
+hash_add(struct cache_shard *shard, unsigned idx)
+{
+	unsigned mask = (1U << shard->hash_bits) - 1;
+	unsigned slot = hash_slot(shard, shard->ce[idx].key);
+
+	while (shard->hash[slot] != CACHE_HASH_EMPTY)
+		slot = (slot + 1) & mask;
+	shard->hash[slot] = idx;
+}
+
+/**  Remove an entry from the hash index.
+ * @param shard  Cache shard (locked).
+ * @param idx    Entry index.
+ *
+ * Nothing happens if the entry is not in the hash index. Otherwise,
+ * following entries in the same probe sequence are shifted back, so
+ * no tombstones are needed.
+ */
+static void
+hash_remove(struct cache_shard *shard, unsigned idx)
+{
+	unsigned mask = (1U << shard->hash_bits) - 1;
+	unsigned slot = hash_slot(shard, shard->ce[idx].key);
+	unsigned next, home;
+
+	while (shard->hash[slot] != idx) {
+		if (shard->hash[slot] == CACHE_HASH_EMPTY)
+			return;
+		slot = (slot + 1) & mask;
+	}
+
+	next = slot;
+	for (;;) {
+		shard->hash[slot] = CACHE_HASH_EMPTY;
+		do {
+			next = (next + 1) & mask;
+			idx = shard->hash[next];
+			if (idx == CACHE_HASH_EMPTY)
+				return;
+			home = hash_slot(shard, shard->ce[idx].key);
+		} while (((next - home) & mask) < ((next - slot) & mask));
+		shard->hash[slot] = idx;
+		slot = next;
+	}
+}
+
 /**  Temporary information needed during a cache search.
  * This is grouped in a structure to avoid passing an inordinate number
  * of parameters among the various helper functions.
@@ -106,16 +337,16 @@ struct cache_search {
 	unsigned eprec;		/**< End of precious entries; this is the
 				 *   index of the first unused entry. */
 	unsigned uprec;		/**< Index of LRU unused precious entry. */
-	unsigned nuprec;	/**< Number of unused precious entries. */
+	unsigned nuprec;	/**< Non-zero if @c uprec is valid. */
 	unsigned gprobe;	/**< Index of MRU probed ghost entry */
 	unsigned eprobe;	/**< End of probed entries; this is the
 				 *   index of the first unused entry. */
 	unsigned uprobe;	/**< Index of LRU unused probed entry. */
-	unsigned nuprobe;	/**< Number of unused probed entries. */
+	unsigned nuprobe;	/**< Non-zero if @c uprobe is valid. */
 };
 
 /**  Add an entry to the list after a given point.
- * @param cache   Cache object.
+ * @param shard   Cache shard.
  * @param entry   Cache entry to be added.
  * @param idx     Index of @ref entry.
  * @param insidx  Insertion point.
@@ -123,11 +354,11 @@ struct cache_search {
  * The entry is added just after @ref insidx.
  */
 static void
-add_entry_after(struct cache *cache, struct cache_entry *entry, unsigned idx,
-		unsigned insidx)
+add_entry_after(struct cache_shard *shard, struct cache_entry *entry,
+		unsigned idx, unsigned insidx)
 {
-	struct cache_entry *prev = &cache->ce[insidx];
-	struct cache_entry *next = &cache->ce[prev->next];
+	struct cache_entry *prev = &shard->ce[insidx];
+	struct cache_entry *next = &shard->ce[prev->next];
 	entry->next = prev->next;
 	prev->next = idx;
 	entry->prev = next->prev;
@@ -135,7 +366,7 @@ add_entry_after(struct cache *cache, struct cache_entry *entry, unsigned idx,
 }
 
 /**  Add an entry to the list before a given point.
- * @param cache   Cache object.
+ * @param shard   Cache shard.
  * @param entry   Cache entry to be added.
  * @param idx     Index of @ref entry.
  * @param insidx  Insertion point.
@@ -143,11 +374,11 @@ add_entry_after(struct cache *cache, struct cache_entry *entry, unsigned idx,
  * The entry is added just before @ref insidx.
  */
 static void
-add_entry_before(struct cache *cache, struct cache_entry *entry, unsigned idx,
-		 unsigned insidx)
+add_entry_before(struct cache_shard *shard, struct cache_entry *entry,
+		 unsigned idx, unsigned insidx)
 {
-	struct cache_entry *next = &cache->ce[insidx];
-	struct cache_entry *prev = &cache->ce[next->prev];
+	struct cache_entry *next = &shard->ce[insidx];
+	struct cache_entry *prev = &shard->ce[next->prev];
 	entry->next = prev->next;
 	prev->next = idx;
 	entry->prev = next->prev;
@@ -156,116 +387,254 @@ add_entry_before(struct cache *cache, struct cache_entry *entry, unsigned idx,
 
 /**  Remove a cache entry from a list.
  *
- * @param cache  Cache object.
+ * @param shard  Cache shard.
  * @param entry  Cache entry to be removed.
  */
 static void
-remove_entry(struct cache *cache, struct cache_entry *entry)
+remove_entry(struct cache_shard *shard, struct cache_entry *entry)
 {
 	struct cache_entry *prev, *next;
 
-	next = &cache->ce[entry->next];
+	next = &shard->ce[entry->next];
 	next->prev = entry->prev;
-	prev = &cache->ce[entry->prev];
+	prev = &shard->ce[entry->prev];
 	prev->next = entry->next;
 }
 
+/**  Update the LRU index of a list when an entry leaves the list.
+ *
+ * @param lru    LRU index of the list.
+ * @param n      Number of entries in the list, including @p idx.
+ * @param idx    Index of the leaving entry.
+ * @param newer  Index of the neighbour of @p idx on the MRU side.
+ *
+ * If the list becomes empty, the LRU index is not used any more.
+ */
+static inline void
+leave_lru(unsigned *lru, unsigned n, unsigned idx, unsigned newer)
+{
+	if (*lru == idx && n > 1)
+		*lru = newer;
+}
+
+/**  Update the LRU index of a list when an entry is added at MRU.
+ *
+ * @param lru  LRU index of the list.
+ * @param n    Number of entries in the list, excluding @p idx.
+ * @param idx  Index of the new entry.
+ */
+static inline void
+join_lru(unsigned *lru, unsigned n, unsigned idx)
+{
+	if (!n)
+		*lru = idx;
+}
+
 /**  Add an entry to the inflight list.
  *
- * @param cache  Cache object.
+ * @param shard  Cache shard.
  * @param entry  Cache entry to be removed.
  * @param idx    Cache entry index.
  */
 static void
-add_inflight(struct cache *cache, struct cache_entry *entry, unsigned idx)
+add_inflight(struct cache_shard *shard, struct cache_entry *entry,
+	     unsigned idx)
 {
-	if (cache->ninflight++)
-		add_entry_before(cache, entry, idx, cache->inflight);
+	if (shard->ninflight++)
+		add_entry_before(shard, entry, idx, shard->inflight);
 	else
-		cache->inflight = entry->next = entry->prev = idx;
+		shard->inflight = entry->next = entry->prev = idx;
+	if (shard->ninflight > shard->inflight_max)
+		shard->inflight_max = shard->ninflight;
 }
 
 /**  Ensure that a locked in-flight entry goes to the precious list.
  *
- * @param cache  Cache object (locked).
+ * @param shard  Cache shard (locked).
  * @param entry  Cache entry.
  */
 static void
-make_precious(struct cache *cache, struct cache_entry *entry)
+make_precious(struct cache_shard *shard, struct cache_entry *entry)
 {
 	if (entry->state == cs_probe) {
-		--cache->nprobetotal;
+		--shard->nprobetotal;
 		entry->state = cs_precious;
 	}
 }
 
 /**  Reuse a cached entry.
  *
- * @param cache  Cache object.
+ * @param shard  Cache shard.
  * @param entry  Cache entry to be moved.
  * @param idx    Index of @ref entry.
  *
  * Move a cache entry to the MRU position of the precious list.
  */
 static void
-reuse_cached_entry(struct cache *cache, struct cache_entry *entry,
+reuse_cached_entry(struct cache_shard *shard, struct cache_entry *entry,
 		   unsigned idx)
 {
-	if (cache->split != idx && cache->split != entry->prev) {
-		remove_entry(cache, entry);
-		add_entry_after(cache, entry, idx, cache->split);
+	if (shard->split != idx && shard->split != entry->prev) {
+		remove_entry(shard, entry);
+		add_entry_after(shard, entry, idx, shard->split);
 	}
 
-	cache->split = entry->prev;
+	shard->split = entry->prev;
+
+	++shard->hits;
+}
+
+/**  Move a probed entry to the MRU position of the probe list.
+ *
+ * @param shard  Cache shard.
+ * @param entry  Cached entry on the probe list.
+ * @param idx    Index of @ref entry.
+ */
+static void
+move_probe_mru(struct cache_shard *shard, struct cache_entry *entry,
+	       unsigned idx)
+{
+	leave_lru(&shard->lruprobe, shard->nprobe, idx, entry->next);
+	join_lru(&shard->lruprobe, shard->nprobe - 1, idx);
+	if (shard->split != idx) {
+		remove_entry(shard, entry);
+		add_entry_after(shard, entry, idx, shard->split);
+		shard->split = idx;
+	}
+}
+
+/**  Account for the first access to an entry.
+ *
+ * @param shard  Cache shard.
+ * @param entry  Cache entry.
+ *
+ * If the entry was read ahead, clear the flag and count a read-ahead
+ * hit, because the read-ahead was useful.
+ */
+static inline void
+use_readahead_entry(struct cache_shard *shard, struct cache_entry *entry)
+{
+	if (entry->readahead) {
+		entry->readahead = false;
+		++shard->ra_hits;
+	}
+}
 
-	++cache->hits.number;
+/**  Reuse a read-ahead entry.
+ *
+ * @param shard  Cache shard.
+ * @param entry  Cache entry to be moved.
+ * @param idx    Index of @ref entry.
+ *
+ * Move a cache entry to the MRU position of the probe list. The first
+ * access to a page which was read ahead is not a reuse, so the entry
+ * is not promoted to the precious list. This prevents sequential scans
+ * from flushing the working set.
+ */
+static void
+reuse_readahead_entry(struct cache_shard *shard, struct cache_entry *entry,
+		      unsigned idx)
+{
+	use_readahead_entry(shard, entry);
+	move_probe_mru(shard, entry, idx);
+	++shard->hits;
 }
 
 /**  Evict an entry from the probe list.
- * @param cache  Cache object.
+ * @param shard  Cache shard.
  * @param cs     Cache search info.
  * @returns      The evicted entry.
  */
 static struct cache_entry *
-evict_probe(struct cache *cache, struct cache_search *cs)
+evict_probe(struct cache_shard *shard, struct cache_search *cs)
 {
-	struct cache_entry *entry = &cache->ce[cs->uprobe];
+	struct cache_entry *entry = &shard->ce[cs->uprobe];
+	leave_lru(&shard->lruprobe, shard->nprobe, cs->uprobe, entry->next);
+	join_lru(&shard->lrugprobe, shard->ngprobe, cs->uprobe);
 	if (entry->prev != cs->gprobe) {
-		if (cs->uprobe == cache->split)
-			cache->split = entry->prev;
-		remove_entry(cache, entry);
-		add_entry_after(cache, entry, cs->uprobe, cs->gprobe);
+		if (cs->uprobe == shard->split)
+			shard->split = entry->prev;
+		remove_entry(shard, entry);
+		add_entry_after(shard, entry, cs->uprobe, cs->gprobe);
 	}
-	--cache->nprobe;
-	++cache->ngprobe;
+	--shard->nprobe;
+	++shard->ngprobe;
 	return entry;
 }
 
 /**  Evict an entry from the precious list.
- * @param cache  Cache object.
+ * @param shard  Cache shard.
  * @param cs     Cache search info.
  * @returns      The evicted entry.
  */
 static struct cache_entry *
-evict_prec(struct cache *cache, struct cache_search *cs)
+evict_prec(struct cache_shard *shard, struct cache_search *cs)
 {
-	struct cache_entry *entry = &cache->ce[cs->uprec];
+	struct cache_entry *entry = &shard->ce[cs->uprec];
+	leave_lru(&shard->lruprec, shard->nprec, cs->uprec, entry->prev);
+	join_lru(&shard->lrugprec, shard->ngprec, cs->uprec);
 	if (entry->next != cs->gprec) {
-		remove_entry(cache, entry);
-		add_entry_before(cache, entry, cs->uprec, cs->gprec);
+		remove_entry(shard, entry);
+		add_entry_before(shard, entry, cs->uprec, cs->gprec);
 	}
-	--cache->nprec;
-	++cache->ngprec;
+	--shard->nprec;
+	++shard->ngprec;
 	return entry;
 }
 
+/**  Take a spare data slot.
+ *
+ * @param shard  Cache shard with at least one spare data slot.
+ * @returns      Data pointer.
+ */
+static void *
+take_spare(struct cache_shard *shard)
+{
+	struct cache_chunk *chunk = shard->chunks;
+
+	while (!chunk->nfree)
+		chunk = chunk->next;
+	--shard->nspare;
+	return chunk->data +
+		(chunk->n - chunk->nfree--) * shard->cache->elemsize;
+}
+
+/**  Take data from an unused entry.
+ *
+ * @param shard  Cache shard.
+ * @param idx    Index of the first unused entry.
+ * @returns      Data pointer.
+ *
+ * This is needed if there are no spare data slots, and all cached
+ * entries are in use. Such a shard still has unused entries with data,
+ * but after the shard grows, they may be preceded by entries without
+ * data, so they must be searched for.
+ */
+static void *
+take_unused_data(struct cache_shard *shard, unsigned idx)
+{
+	struct cache_entry *entry;
+	void *data;
+
+	for (;;) {
+		entry = &shard->ce[idx];
+		if (entry->data && !entry->refcnt)
+			break;
+		idx = entry->prev;
+	}
+	data = entry->data;
+	entry->data = NULL;
+	return data;
+}
+
 /**  Re-initialize an entry for different data.
  *
- * @param cache  Cache object.
+ * @param shard  Cache shard.
  * @param entry  Entry to be reinitialized.
  * @param cs     Cache search info.
  *
- * Evict an entry from the cache and use its data pointer for @ref entry.
+ * If the shard has a spare data slot, use it. Otherwise, evict an entry
+ * from the cache and use its data pointer for @ref entry.
  * The evicted entry is taken either from the probe list or from the
  * precious list, depending on the value of @c dprobe.
  * This function is used for pages that will be added to the probe list,
@@ -274,11 +643,20 @@ evict_prec(struct cache *cache, struct cache_search *cs)
  * @sa reuse_ghost_entry
  */
 static void
-reinit_entry(struct cache *cache, struct cache_entry *entry,
+reinit_entry(struct cache_shard *shard, struct cache_entry *entry,
 	     struct cache_search *cs)
 {
 	struct cache_entry *evict;
-	int delta = cache->dprobe - cache->nprobe;
+	int delta = shard->dprobe - shard->nprobe;
+
+	if (shard->nspare) {
+		entry->data = take_spare(shard);
+		return;
+	}
+	if (!cs->nuprobe && !cs->nuprec) {
+		entry->data = take_unused_data(shard, cs->eprobe);
+		return;
+	}
 
 	if (delta <= 0 && cs->nuprobe == 0)
 		delta = 1;
@@ -286,11 +664,13 @@ reinit_entry(struct cache *cache, struct cache_entry *entry,
 		delta = 0;
 
 	if (delta <= 0)
-		evict = evict_probe(cache, cs);
+		evict = evict_probe(shard, cs);
 	else
-		evict = evict_prec(cache, cs);
-	if (cache->entry_cleanup)
-		cache->entry_cleanup(cache->cleanup_data, evict);
+		evict = evict_prec(shard, cs);
+	++shard->evictions;
+	if (shard->cache->entry_cleanup)
+		shard->cache->entry_cleanup(
+			shard->cache->cleanup_data, evict);
 
 	entry->data = evict->data;
 	evict->data = NULL;
@@ -298,51 +678,65 @@ reinit_entry(struct cache *cache, struct cache_entry *entry,
 
 /**  Get a cache entry for a given missed key.
  *
- * @param cache  Cache object.
+ * @param shard  Cache shard.
  * @param key    Requested key.
  * @param cs     Cache search info.
  * @returns      A new cache entry.
  */
 static struct cache_entry *
-get_missed_entry(struct cache *cache, cache_key_t key,
+get_missed_entry(struct cache_shard *shard, cache_key_t key,
 		 struct cache_search *cs)
 {
 	struct cache_entry *entry;
 	unsigned idx;
 
-	++cache->nprobetotal;
+	++shard->nprobetotal;
 	idx = cs->eprobe;
-	entry = &cache->ce[idx];
+	entry = &shard->ce[idx];
 	if (entry->next == cs->eprec) {
-		if (cache->nprobetotal > cache->cap) {
+		/* Without probe ghosts, the next entry is the LRU probe
+		 * entry, which cannot be reused while somebody holds it. */
+		if (shard->nprobetotal > shard->cap &&
+		    (shard->ngprobe || !shard->ce[entry->next].refcnt)) {
 			idx = entry->next;
-			entry = &cache->ce[idx];
-			if (cache->ngprobe)
-				--cache->ngprobe;
-			else
-				--cache->nprobe;
-			--cache->nprobetotal;
-		} else if (cache->ngprec)
-			   --cache->ngprec;
+			entry = &shard->ce[idx];
+			if (shard->ngprobe) {
+				leave_lru(&shard->lrugprobe, shard->ngprobe,
+					  idx, entry->next);
+				--shard->ngprobe;
+			} else {
+				leave_lru(&shard->lruprobe, shard->nprobe,
+					  idx, entry->next);
+				--shard->nprobe;
+			}
+			--shard->nprobetotal;
+		} else if (shard->ngprec) {
+			leave_lru(&shard->lrugprec, shard->ngprec,
+				  idx, entry->prev);
+			--shard->ngprec;
+		}
 	}
 
 	if (!entry->data)
-		reinit_entry(cache, entry, cs);
+		reinit_entry(shard, entry, cs);
 
-	if (cache->split == idx)
-		cache->split = entry->prev;
+	if (shard->split == idx)
+		shard->split = entry->prev;
 
-	remove_entry(cache, entry);
-	add_inflight(cache, entry, idx);
+	remove_entry(shard, entry);
+	add_inflight(shard, entry, idx);
+	hash_remove(shard, idx);
 	entry->key = key;
+	hash_add(shard, idx);
 	entry->state = cs_probe;
+	entry->readahead = false;
 
 	return entry;
 }
 
 /**  Reuse a ghost entry.
  *
- * @param cache  Cache object.
+ * @param shard  Cache shard.
  * @param entry  Ghost entry to be reused.
  * @param idx    Index of @ref entry.
  * @param cs     Cache search info.
@@ -354,272 +748,845 @@ get_missed_entry(struct cache *cache, cache_key_t key,
  * @sa reinit_entry
  */
 static void
-reuse_ghost_entry(struct cache *cache, struct cache_entry *entry,
+reuse_ghost_entry(struct cache_shard *shard, struct cache_entry *entry,
 		  unsigned idx, struct cache_search *cs)
 {
 	struct cache_entry *evict;
-	int delta = cache->dprobe - cache->nprobe;
+	int delta = shard->dprobe - shard->nprobe;
 
 	if (delta < 0 && cs->nuprobe == 0)
 		delta = 0;
 	else if (delta >= 0 && cs->nuprec == 0)
 		delta = -1;
 
-	if (delta < 0)
-		evict = evict_probe(cache, cs);
-	else
-		evict = evict_prec(cache, cs);
-	if (cache->entry_cleanup)
-		cache->entry_cleanup(cache->cleanup_data, evict);
-
-	entry->data = evict->data;
-	evict->data = NULL;
+	if (shard->nspare)
+		entry->data = take_spare(shard);
+	else if (!cs->nuprobe && !cs->nuprec)
+		entry->data = take_unused_data(shard, cs->eprobe);
+	else {
+		if (delta < 0)
+			evict = evict_probe(shard, cs);
+		else
+			evict = evict_prec(shard, cs);
+		++shard->evictions;
+		if (shard->cache->entry_cleanup)
+			shard->cache->entry_cleanup(
+				shard->cache->cleanup_data, evict);
+
+		entry->data = evict->data;
+		evict->data = NULL;
+	}
 
-	if (cache->split == idx)
-		cache->split = entry->prev;
+	if (shard->split == idx)
+		shard->split = entry->prev;
 
-	remove_entry(cache, entry);
-	add_inflight(cache, entry, idx);
+	remove_entry(shard, entry);
+	add_inflight(shard, entry, idx);
 	entry->state = cs_precious;
+	entry->readahead = false;
 }
 
-/**  Get the ghost entry for a given key.
+/**  Reuse a ghost entry for a given key.
  *
- * @param cache  Cache object.
- * @param key    Key to be searched.
+ * @param shard  Cache shard.
+ * @param idx    Index of the ghost entry.
  * @param cs     Cache search info.
- * @returns      Ghost entry, or @c NULL if not found.
- *
- * If no entry is found (function returns @c NULL), the @c epreca and
- * @c eprobe fields in @ref cs are updated. Otherwise (if an entry is
- * found), their values are undefined.
+ * @returns      The ghost entry, now in flight.
  */
 static struct cache_entry *
-get_ghost_entry(struct cache *cache, cache_key_t key,
+get_ghost_entry(struct cache_shard *shard, unsigned idx,
 		struct cache_search *cs)
 {
-	struct cache_entry *entry;
-	unsigned n, idx;
-
-	/* Search precious ghost entries */
-	n = cache->ngprec;
-	idx = cs->gprec;
-	while (n--) {
-		entry = &cache->ce[idx];
-		if (entry->key == key) {
-			int delta = cache->ngprobe > cache->ngprec
-				? cache->ngprobe / cache->ngprec
-				: 1;
-			if (cache->dprobe > delta)
-				cache->dprobe -= delta;
-			else
-				cache->dprobe = 0;
-			--cache->ngprec;
-			reuse_ghost_entry(cache, entry, idx, cs);
-			return entry;
-		}
-		idx = entry->next;
-	}
-	cs->eprec = idx;
-
-	/* Search probed ghost entries */
-	n = cache->ngprobe;
-	idx = cs->gprobe;
-	while (n--) {
-		entry = &cache->ce[idx];
-		if (entry->key == key) {
-			int delta = cache->ngprec > cache->ngprobe
-				? cache->ngprec / cache->ngprobe
-				: 1;
-			if (cache->dprobe + delta < cache->cap)
-				cache->dprobe += delta;
-			else
-				cache->dprobe = cache->cap;
-			--cache->ngprobe;
-			--cache->nprobetotal;
-			reuse_ghost_entry(cache, entry, idx, cs);
-			return entry;
-		}
-		idx = entry->prev;
+	struct cache_entry *entry = &shard->ce[idx];
+
+	if (entry->precious) {
+		int delta = shard->ngprobe > shard->ngprec
+			? shard->ngprobe / shard->ngprec
+			: 1;
+		if (shard->dprobe > delta)
+			shard->dprobe -= delta;
+		else
+			shard->dprobe = 0;
+		leave_lru(&shard->lrugprec, shard->ngprec, idx, entry->prev);
+		--shard->ngprec;
+	} else {
+		int delta = shard->ngprec > shard->ngprobe
+			? shard->ngprec / shard->ngprobe
+			: 1;
+		if (shard->dprobe + delta < shard->cap)
+			shard->dprobe += delta;
+		else
+			shard->dprobe = shard->cap;
+		leave_lru(&shard->lrugprobe, shard->ngprobe, idx, entry->next);
+		--shard->ngprobe;
+		--shard->nprobetotal;
 	}
-	cs->eprobe = idx;
-
-	return NULL;
+	++shard->ghost_hits;
+	++shard->adapt_ghosts;
+	reuse_ghost_entry(shard, entry, idx, cs);
+	return entry;
 }
 
-/**  Get the in-flight entry for a given key.
+/**  Reuse a cached or in-flight entry.
  *
- * @param cache  Cache object.
- * @param key    Key to be searched.
- * @returns      In-flight entry, or @c NULL if there is none.
+ * @param shard  Cache shard.
+ * @param idx    Index of an entry with data.
+ * @returns      The entry.
+ *
+ * A cached entry is moved to the MRU position of the corresponding
+ * list, and this counts as a hit. An in-flight entry is returned as is,
+ * and this counts as a miss.
  */
 static struct cache_entry *
-get_inflight_entry(struct cache *cache, cache_key_t key)
+reuse_entry(struct cache_shard *shard, unsigned idx)
 {
-	struct cache_entry *entry;
-	unsigned idx, n;
+	struct cache_entry *entry = &shard->ce[idx];
 
-	idx = cache->inflight;
-	for (n = cache->ninflight; n; --n) {
-		entry = &cache->ce[idx];
-		if (entry->key == key) {
-			make_precious(cache, entry);
+	if (!cache_entry_valid(entry)) {
+		if (!entry->readahead)
+			make_precious(shard, entry);
+		++shard->misses;
+		return entry;
+	}
+
+	if (entry->precious) {
+		leave_lru(&shard->lruprec, shard->nprec, idx, entry->prev);
+		join_lru(&shard->lruprec, shard->nprec - 1, idx);
+	} else {
+		if (entry->readahead) {
+			reuse_readahead_entry(shard, entry, idx);
 			return entry;
 		}
-		idx = entry->next;
+		leave_lru(&shard->lruprobe, shard->nprobe, idx, entry->next);
+		join_lru(&shard->lruprec, shard->nprec, idx);
+		--shard->nprobe;
+		++shard->nprec;
+		--shard->nprobetotal;
+		entry->precious = true;
 	}
-
-	return NULL;
+	reuse_cached_entry(shard, entry, idx);
+	return entry;
 }
 
-/**  Search the cache for an entry.
+/**  Find section boundaries and eviction candidates.
  *
- * @param cache  Cache object.
- * @param key    Key to be searched.
- * @returns      Pointer to a cache entry, or @c NULL if cache is full.
+ * @param shard  Cache shard.
+ * @param cs     Cache search info (filled in).
+ *
+ * Section boundaries are found from the LRU entries of each list.
+ * Eviction candidates are searched from the LRU end, so usually only
+ * a few entries are visited.
  */
-static struct cache_entry *
-cache_get_entry_noref(struct cache *cache, cache_key_t key)
+static void
+search_shard(struct cache_shard *shard, struct cache_search *cs)
 {
-	struct cache_search cs;
 	struct cache_entry *entry;
 	unsigned n, idx;
 
-	cs.nuprec = 0;
-	cs.nuprobe = 0;
-
-	/* Search precious entries */
-	n = cache->nprec;
-	idx = cache->ce[cache->split].next;
-	while (n--) {
-		entry = &cache->ce[idx];
-		if (entry->key == key) {
-			reuse_cached_entry(cache, entry, idx);
-			return entry;
-		}
+	cs->gprec = shard->nprec
+		? shard->ce[shard->lruprec].next
+		: shard->ce[shard->split].next;
+	cs->eprec = shard->ngprec
+		? shard->ce[shard->lrugprec].next
+		: cs->gprec;
+	cs->gprobe = shard->nprobe
+		? shard->ce[shard->lruprobe].prev
+		: shard->split;
+	cs->eprobe = shard->ngprobe
+		? shard->ce[shard->lrugprobe].prev
+		: cs->gprobe;
+
+	cs->nuprec = 0;
+	idx = shard->lruprec;
+	for (n = shard->nprec; n; --n) {
+		entry = &shard->ce[idx];
 		if (entry->refcnt == 0) {
-			cs.uprec = idx;
-			++cs.nuprec;
+			cs->uprec = idx;
+			cs->nuprec = 1;
+			break;
 		}
-		idx = entry->next;
+		idx = entry->prev;
 	}
-	cs.gprec = idx;
 
-	/* Search probed entries */
-	n = cache->nprobe;
-	idx = cache->split;
-	while (n--) {
-		entry = &cache->ce[idx];
-		if (entry->key == key) {
-			--cache->nprobe;
-			++cache->nprec;
-			--cache->nprobetotal;
-			reuse_cached_entry(cache, entry, idx);
-			return entry;
-		}
+	cs->nuprobe = 0;
+	idx = shard->lruprobe;
+	for (n = shard->nprobe; n; --n) {
+		entry = &shard->ce[idx];
 		if (entry->refcnt == 0) {
-			cs.uprobe = idx;
-			++cs.nuprobe;
+			cs->uprobe = idx;
+			cs->nuprobe = 1;
+			break;
 		}
-		idx = entry->prev;
-	}
-	cs.gprobe = idx;
-
-	entry = get_inflight_entry(cache, key);
-
-	if (!entry) {
-		unsigned inuse = (cache->nprec - cs.nuprec) +
-			(cache->nprobe - cs.nuprobe) +
-			cache->ninflight;
-		if (inuse >= cache->cap)
-			return NULL;
+		idx = entry->next;
 	}
+}
 
-	if (!entry)
-		entry = get_ghost_entry(cache, key, &cs);
-	if (!entry)
-		entry = get_missed_entry(cache, key, &cs);
-
-	++cache->misses.number;
+/**  Reuse a cached or in-flight entry without moving it.
+ *
+ * @param shard  Cache shard.
+ * @param idx    Index of an entry with data.
+ * @returns      The entry.
+ *
+ * The entry stays where it is, so entries are evicted in the order
+ * in which they were loaded.
+ */
+static struct cache_entry *
+fifo_reuse_entry(struct cache_shard *shard, unsigned idx)
+{
+	struct cache_entry *entry = &shard->ce[idx];
 
+	if (!cache_entry_valid(entry))
+		++shard->misses;
+	else
+		++shard->hits;
 	return entry;
 }
 
-/**  Get the cache entry for a given key.
- *
- * @param cache  Cache object.
- * @param key    Key to be searched.
- * @returns      Pointer to a cache entry, or @c NULL if cache is full.
+/**  Reuse a cached or in-flight entry and mark it as referenced.
  *
- * On a cache hit (corresponding entry is found in the cache), the returned
- * entry denotes the cached data.
- * On a cache miss, the returned entry can be used to load data into the
- * cache and store it for later use with @ref cache_insert.
+ * @param shard  Cache shard.
+ * @param idx    Index of an entry with data.
+ * @returns      The entry.
  *
- * The reference count of the returned entry is incremented.
+ * Pages which were read ahead are not marked on their first access,
+ * for the same reason as in @ref reuse_readahead_entry.
  */
-struct cache_entry *
-cache_get_entry(struct cache *cache, cache_key_t key)
+static struct cache_entry *
+clock_reuse_entry(struct cache_shard *shard, unsigned idx)
 {
-	struct cache_entry *entry;
+	struct cache_entry *entry = fifo_reuse_entry(shard, idx);
 
-	entry = cache_get_entry_noref(cache, key);
-	if (entry)
-		++entry->refcnt;
+	if (cache_entry_valid(entry)) {
+		if (entry->readahead)
+			use_readahead_entry(shard, entry);
+		else
+			entry->referenced = true;
+	}
+	return entry;
+}
 
+/**  Reuse a ghost entry for a given key without promoting it.
+ *
+ * @param shard  Cache shard.
+ * @param idx    Index of the ghost entry.
+ * @param cs     Cache search info.
+ * @returns      The ghost entry, now in flight.
+ *
+ * Unlike @ref get_ghost_entry, the entry goes to the probe list, and
+ * the desired size of the probe list is not adapted.
+ */
+static struct cache_entry *
+get_ghost_probe(struct cache_shard *shard, unsigned idx,
+		struct cache_search *cs)
+{
+	struct cache_entry *entry = &shard->ce[idx];
+
+	if (entry->precious) {
+		leave_lru(&shard->lrugprec, shard->ngprec, idx, entry->prev);
+		--shard->ngprec;
+		++shard->nprobetotal;
+	} else {
+		leave_lru(&shard->lrugprobe, shard->ngprobe, idx, entry->next);
+		--shard->ngprobe;
+	}
+	++shard->ghost_hits;
+	++shard->adapt_ghosts;
+	reuse_ghost_entry(shard, entry, idx, cs);
+	entry->state = cs_probe;
 	return entry;
 }
 
-/**  Insert an entry into the cache.
+/**  Give referenced entries a second chance before an eviction.
  *
- * @param cache  Cache object.
- * @param entry  Cache entry (with data).
+ * @param shard  Cache shard.
  *
- * Note that this function does **NOT** drop the reference to @p entry.
- * This is necessary to allow callers inserting an entry to the cache as
- * soon as possible, while using the data afterwards.
+ * Referenced entries at the LRU end of the probe list are moved to
+ * the MRU end, and their reference mark is cleared. Entries which are
+ * in use are moved as well, because they cannot be evicted anyway.
+ * The sweep stops at the first entry which can be evicted, or after
+ * visiting each entry once.
  */
-void
-cache_insert(struct cache *cache, struct cache_entry *entry)
+static void
+clock_sweep(struct cache_shard *shard)
 {
-	unsigned idx;
+	struct cache_entry *entry;
+	unsigned n, idx;
 
-	if (cache_entry_valid(entry))
+	if (shard->nspare)
 		return;
 
-	idx = entry - cache->ce;
-	if (cache->ninflight--) {
-		if (cache->inflight == idx)
-			cache->inflight = entry->next;
-		remove_entry(cache, entry);
+	for (n = shard->nprobe; n; --n) {
+		idx = shard->lruprobe;
+		entry = &shard->ce[idx];
+		if (!entry->referenced && !entry->refcnt)
+			break;
+		entry->referenced = false;
+		move_probe_mru(shard, entry, idx);
 	}
-	add_entry_after(cache, entry, idx, cache->split);
+}
 
-	switch (entry->state) {
-	case cs_probe:
-		++cache->nprobe;
-		cache->split = idx;
-		break;
+/**  Cache replacement policy.
+ *
+ * All functions are called with the shard locked.
+ */
+struct cache_policy {
+	/** Policy name, as used by the @c cache.policy attribute. */
+	const char *name;
 
-	case cs_precious:
-		++cache->nprec;
-		break;
+	/** Reuse a cached or in-flight entry. */
+	struct cache_entry *(*reuse)(struct cache_shard *shard, unsigned idx);
 
-	default:		/* Make -Wswitch happy. */
-		break;
-	}
-	entry->state = cs_valid;
-}
+	/** Reuse a ghost entry for a cache miss. */
+	struct cache_entry *(*ghost)(struct cache_shard *shard, unsigned idx,
+				     struct cache_search *cs);
 
-/**  Drop a reference to a cache entry.
+	/** Prepare the shard for a cache miss (optional). */
+	void (*prepare_miss)(struct cache_shard *shard);
+};
+
+/**  Available cache replacement policies.
  *
- * @param cache  Cache object.
- * @param entry  Cache entry.
+ * The first policy is the default.
+ */
+static const struct cache_policy cache_policies[] = {
+	/* Adaptive probe/precious lists. */
+	{ "arc", reuse_entry, get_ghost_entry, NULL },
+
+	/* Evict in load order; hits are not tracked at all. */
+	{ "fifo", fifo_reuse_entry, get_ghost_probe, NULL },
+
+	/* Second chance for entries which were hit since the last sweep. */
+	{ "clock", clock_reuse_entry, get_ghost_probe, clock_sweep },
+};
+
+/**  Search the cache for an entry.
+ *
+ * @param shard  Cache shard.
+ * @param key    Key to be searched.
+ * @returns      Pointer to a cache entry, or @c NULL if cache is full.
+ */
+static struct cache_entry *
+cache_get_entry_noref(struct cache_shard *shard, cache_key_t key)
+{
+	const struct cache_policy *policy = shard->policy;
+	struct cache_search cs;
+	struct cache_entry *entry;
+	unsigned idx;
+
+	idx = hash_find(shard, key);
+	if (idx != CACHE_HASH_EMPTY && shard->ce[idx].data)
+		return policy->reuse(shard, idx);
+
+	if (shard->nheld >= shard->cap)
+		return NULL;
+
+	if (policy->prepare_miss)
+		policy->prepare_miss(shard);
+	search_shard(shard, &cs);
+	entry = (idx != CACHE_HASH_EMPTY)
+		? policy->ghost(shard, idx, &cs)
+		: get_missed_entry(shard, key, &cs);
+
+	++shard->misses;
+
+	return entry;
+}
+
+/**  Check whether a referenced entry can be used by the caller.
+ *
+ * @param entry  Cache entry, or @c NULL.
+ * @returns      @c true if @p entry is either valid, or it is in flight
+ *               but nobody is loading its data.
+ */
+static inline bool
+entry_ready(struct cache_entry *entry)
+{
+	return entry && (cache_entry_valid(entry) || !entry->busy);
+}
+
+/**  Take a reference to a cache entry.
+ *
+ * @param shard  Cache shard (locked).
+ * @param entry  Cache entry, or @c NULL.
+ */
+static inline void
+hold_entry(struct cache_shard *shard, struct cache_entry *entry)
+{
+	if (entry && !entry->refcnt++)
+		++shard->nheld;
+}
+
+/**  Wake up all threads waiting for an entry in a shard.
+ *
+ * @param shard  Cache shard (locked).
+ */
+static inline void
+wake_waiters(struct cache_shard *shard)
+{
+	if (shard->nwaiters)
+		cond_broadcast(&shard->cond);
+}
+
+/**  Wait until an entry for a given key can be used.
+ *
+ * @param shard  Cache shard (locked).
+ * @param key    Requested key.
+ * @param entry  Referenced in-flight entry, or @c NULL if the shard is full.
+ * @returns      Referenced cache entry, or @c NULL on failure.
+ *
+ * Block until the in-flight @p entry is inserted or discarded by the
+ * thread which is loading its data, or (if @p entry is @c NULL) until
+ * some other entry is released. If waiting fails, the reference to
+ * @p entry is dropped, and @c NULL is returned, so the caller never
+ * gets an entry which is still being loaded.
+ */
+static struct cache_entry *
+wait_entry(struct cache_shard *shard, cache_key_t key,
+	   struct cache_entry *entry)
+{
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	++shard->waits;
+	++shard->nwaiters;
+	do {
+		if (cond_wait(&shard->cond, &shard->mutex)) {
+			/* The loading thread still holds a reference,
+			 * so dropping ours cannot free the entry. */
+			if (entry && !entry_ready(entry)) {
+				--entry->refcnt;
+				entry = NULL;
+			}
+			break;
+		}
+		if (!entry) {
+			entry = cache_get_entry_noref(shard, key);
+			hold_entry(shard, entry);
+		}
+	} while (!entry_ready(entry));
+	--shard->nwaiters;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	shard->wait_time += (end.tv_sec - start.tv_sec) * 1000000000ULL +
+		end.tv_nsec - start.tv_nsec;
+	return entry;
+}
+
+/**  Find the LRU entry of the probe list.
+ *
+ * @param shard  Cache shard (locked).
+ * @returns      Index of the LRU probed ghost entry, or of the LRU
+ *               probed entry if there are no probed ghosts.
+ *
+ * The result is meaningless if both the probe list and the ghost probe
+ * list are empty.
+ */
+static unsigned
+find_lruprobe(struct cache_shard *shard)
+{
+	return shard->ngprobe ? shard->lrugprobe : shard->lruprobe;
+}
+
+/**  Add an entry to the unused pool.
+ *
+ * @param shard     Cache shard (locked).
+ * @param entry     Cache entry (not on any list).
+ * @param idx       Index of @ref entry.
+ * @param lruprobe  Index of the LRU probe entry (see @ref find_lruprobe).
+ *
+ * The entry is added just before the LRU probed ghost entry, or before
+ * the LRU probed entry if there are no probed ghosts. Note that the
+ * predecessor of that entry is not necessarily unused; if the pool is
+ * empty and there are no precious entries, it is the MRU probed entry.
+ */
+static void
+add_unused(struct cache_shard *shard, struct cache_entry *entry,
+	   unsigned idx, unsigned lruprobe)
+{
+	if (shard->nprobe + shard->ngprobe)
+		add_entry_before(shard, entry, idx, lruprobe);
+	else {
+		add_entry_after(shard, entry, idx, shard->split);
+		shard->split = idx;
+	}
+}
+
+/**  Allocate a data chunk.
+ *
+ * @param shard  Cache shard.
+ * @param n      Number of elements.
+ * @returns      Newly allocated chunk, or @c NULL on allocation failure.
+ *
+ * If the shard uses the shared data area, the data is taken from it.
+ * Otherwise, it is allocated together with the chunk.
+ */
+static struct cache_chunk *
+alloc_chunk(struct cache_shard *shard, unsigned n)
+{
+	size_t size = (size_t)n * shard->cache->elemsize;
+	struct cache_chunk *chunk;
+
+	if (shard->pool) {
+		chunk = malloc(sizeof(struct cache_chunk));
+		if (!chunk)
+			return chunk;
+		chunk->data = shard->pool;
+		shard->pool += size;
+	} else {
+		chunk = malloc(sizeof(struct cache_chunk) + size);
+		if (!chunk)
+			return chunk;
+		chunk->data = chunk + 1;
+	}
+
+	chunk->n = n;
+	chunk->nfree = n;
+	return chunk;
+}
+
+/**  Grow a cache shard.
+ *
+ * @param shard  Cache shard (locked).
+ * @param n      Requested capacity.
+ *
+ * The new capacity is capped at the maximum capacity of the shard.
+ * Growing is best-effort; if memory cannot be allocated, the shard
+ * is left unchanged.
+ */
+static void
+grow_shard(struct cache_shard *shard, unsigned n)
+{
+	struct cache_chunk *chunk;
+	unsigned idx, lruprobe;
+
+	if (n > shard->maxcap)
+		n = shard->maxcap;
+	if (n <= shard->cap)
+		return;
+
+	chunk = alloc_chunk(shard, n - shard->cap);
+	if (!chunk)
+		return;
+	chunk->next = shard->chunks;
+	shard->chunks = chunk;
+	shard->nspare += chunk->n;
+
+	lruprobe = find_lruprobe(shard);
+	for (idx = 2 * shard->cap; idx < 2 * n; ++idx) {
+		struct cache_entry *entry = &shard->ce[idx];
+		entry->refcnt = 0;
+		entry->busy = false;
+		entry->data = NULL;
+		add_unused(shard, entry, idx, lruprobe);
+	}
+	shard->cap = n;
+
+	wake_waiters(shard);
+}
+
+/**  Grow a cache shard if its working set seems to be too big.
+ *
+ * @param shard  Cache shard (locked).
+ *
+ * The ghost hit ratio is evaluated after each @c cap lookups.
+ */
+static void
+adapt_shard(struct cache_shard *shard)
+{
+	if (++shard->adapt_lookups < shard->cap)
+		return;
+
+	if (shard->adapt_ghosts >
+	    shard->adapt_lookups >> CACHE_GROW_GHOST_SHIFT)
+		grow_shard(shard, shard->cap +
+			   (shard->cap >> CACHE_GROW_STEP_SHIFT) + 1);
+	shard->adapt_lookups = 0;
+	shard->adapt_ghosts = 0;
+}
+
+/**  Get the cache entry for a given key.
+ *
+ * @param cache  Cache object.
+ * @param key    Key to be searched.
+ * @returns      Pointer to a cache entry, or @c NULL if cache is full.
+ *
+ * On a cache hit (corresponding entry is found in the cache), the returned
+ * entry denotes the cached data.
+ * On a cache miss, the returned entry can be used to load data into the
+ * cache and store it for later use with @ref cache_insert.
+ *
+ * If the cache is in wait mode (see @ref cache_set_wait), this function
+ * blocks while the shard is full or while another thread is loading
+ * data for the same key. Otherwise, it returns @c NULL if the shard is
+ * full, and it may return an entry which is being loaded by another
+ * thread (including a read-ahead, see @ref cache_get_readahead).
+ *
+ * The reference count of the returned entry is incremented.
+ */
+struct cache_entry *
+cache_get_entry(struct cache *cache, cache_key_t key)
+{
+	struct cache_shard *shard = key_shard(cache, key);
+	struct cache_entry *entry;
+
+	mutex_lock(&shard->mutex);
+	entry = cache_get_entry_noref(shard, key);
+	hold_entry(shard, entry);
+	if (shard->cap < shard->maxcap)
+		adapt_shard(shard);
+	if (cache->wait && !entry_ready(entry))
+		entry = wait_entry(shard, key, entry);
+	if (!entry)
+		++shard->busy;
+	else {
+		use_readahead_entry(shard, entry);
+		if (!cache_entry_valid(entry))
+			entry->busy = true;
+	}
+	mutex_unlock(&shard->mutex);
+
+	return entry;
+}
+
+/**  Check whether a key is cached or being loaded.
+ *
+ * @param shard  Cache shard (locked).
+ * @param key    Key to be searched.
+ * @returns      @c true if @p key has a cached or in-flight entry.
+ *
+ * Unlike @ref cache_get_entry_noref, this function does not change
+ * the position of any entry.
+ */
+static bool
+key_present(struct cache_shard *shard, cache_key_t key)
+{
+	unsigned idx = hash_find(shard, key);
+
+	/* Ghost entries have no data. */
+	return idx != CACHE_HASH_EMPTY && shard->ce[idx].data;
+}
+
+/**  Get a cache entry for reading ahead.
+ *
+ * @param cache  Cache object.
+ * @param key    Key to be read ahead.
+ * @returns      A new cache entry, or @c NULL.
+ *
+ * This function never blocks. It returns @c NULL if @p key is already
+ * cached or being loaded, or if the shard is full. Otherwise, it
+ * returns an in-flight entry which must be either inserted with
+ * @ref cache_insert and released with @ref cache_put_entry, or
+ * discarded with @ref cache_discard.
+ *
+ * A page which is loaded this way goes to the probe list, and the
+ * first lookup of its key does not move it to the precious list.
+ */
+struct cache_entry *
+cache_get_readahead(struct cache *cache, cache_key_t key)
+{
+	struct cache_shard *shard = key_shard(cache, key);
+	struct cache_entry *entry;
+
+	mutex_lock(&shard->mutex);
+	entry = key_present(shard, key)
+		? NULL
+		: cache_get_entry_noref(shard, key);
+	if (entry) {
+		hold_entry(shard, entry);
+		entry->busy = true;
+		entry->readahead = (entry->state == cs_probe);
+		++shard->ra_loads;
+	}
+	mutex_unlock(&shard->mutex);
+
+	return entry;
+}
+
+/**  Hold a valid cached entry.
+ *
+ * @param shard  Cache shard (locked).
+ * @param key    Key to be searched.
+ * @returns      A valid cache entry, or @c NULL.
+ */
+static struct cache_entry *
+hold_valid_entry(struct cache_shard *shard, cache_key_t key)
+{
+	struct cache_entry *entry;
+	unsigned idx;
+
+	idx = hash_find(shard, key);
+	if (idx == CACHE_HASH_EMPTY)
+		return NULL;
+	entry = &shard->ce[idx];
+	/* Ghost entries have no data. */
+	if (!entry->data || !cache_entry_valid(entry))
+		return NULL;
+	hold_entry(shard, entry);
+	return entry;
+}
+
+/**  Get a cached entry without changing the cache.
+ *
+ * @param cache  Cache object.
+ * @param key    Key to be searched.
+ * @returns      A valid cache entry, or @c NULL.
+ *
+ * If @p key is cached, the reference count of its entry is incremented,
+ * but the entry stays where it is. Otherwise, this function returns
+ * @c NULL, and no entry is allocated for the key, so the caller must
+ * load the data into its own buffer. An entry which is still in flight
+ * is not returned either.
+ */
+struct cache_entry *
+cache_peek_entry(struct cache *cache, cache_key_t key)
+{
+	struct cache_shard *shard = key_shard(cache, key);
+	struct cache_entry *entry;
+
+	mutex_lock(&shard->mutex);
+	entry = hold_valid_entry(shard, key);
+	if (entry)
+		++shard->hits;
+	else
+		++shard->misses;
+	mutex_unlock(&shard->mutex);
+
+	return entry;
+}
+
+/**  Find a cached entry without counting a lookup.
+ *
+ * @param cache  Cache object.
+ * @param key    Key to be searched.
+ * @returns      A valid cache entry, or @c NULL.
+ *
+ * This function works like @ref cache_peek_entry, but it does not
+ * update the hit and miss counters. It is meant for secondary lookups
+ * after a miss in another cache.
+ */
+struct cache_entry *
+cache_find_entry(struct cache *cache, cache_key_t key)
+{
+	struct cache_shard *shard = key_shard(cache, key);
+	struct cache_entry *entry;
+
+	mutex_lock(&shard->mutex);
+	entry = hold_valid_entry(shard, key);
+	mutex_unlock(&shard->mutex);
+
+	return entry;
+}
+
+/**  Insert an entry into a locked cache shard.
+ *
+ * @param shard  Cache shard (locked).
+ * @param entry  Cache entry (with data).
+ */
+static void
+insert_entry(struct cache_shard *shard, struct cache_entry *entry)
+{
+	unsigned idx;
+
+	if (cache_entry_valid(entry))
+		return;
+
+	idx = entry - shard->ce;
+	if (shard->ninflight--) {
+		if (shard->inflight == idx)
+			shard->inflight = entry->next;
+		remove_entry(shard, entry);
+	}
+	add_entry_after(shard, entry, idx, shard->split);
+
+	switch (entry->state) {
+	case cs_probe:
+		join_lru(&shard->lruprobe, shard->nprobe, idx);
+		++shard->nprobe;
+		shard->split = idx;
+		entry->precious = false;
+		break;
+
+	case cs_precious:
+		join_lru(&shard->lruprec, shard->nprec, idx);
+		++shard->nprec;
+		entry->precious = true;
+		break;
+
+	default:		/* Make -Wswitch happy. */
+		break;
+	}
+	entry->state = cs_valid;
+	entry->busy = false;
+	entry->referenced = false;
+	wake_waiters(shard);
+}
+
+/**  Insert an entry into the cache.
+ *
+ * @param cache  Cache object.
+ * @param entry  Cache entry (with data).
+ *
+ * Note that this function does **NOT** drop the reference to @p entry.
+ * This is necessary to allow callers inserting an entry to the cache as
+ * soon as possible, while using the data afterwards.
+ */
+void
+cache_insert(struct cache *cache, struct cache_entry *entry)
+{
+	struct cache_shard *shard = key_shard(cache, entry->key);
+
+	mutex_lock(&shard->mutex);
+	insert_entry(shard, entry);
+	mutex_unlock(&shard->mutex);
+}
+
+/**  Drop a reference to a cache entry.
+ *
+ * @param cache  Cache object.
+ * @param entry  Cache entry.
  */
 void
 cache_put_entry(struct cache *cache, struct cache_entry *entry)
 {
-	--entry->refcnt;
+	struct cache_shard *shard = key_shard(cache, entry->key);
+
+	mutex_lock(&shard->mutex);
+	if (!--entry->refcnt) {
+		--shard->nheld;
+		wake_waiters(shard);
+	}
+	mutex_unlock(&shard->mutex);
+}
+
+/**  Discard an entry in a locked cache shard.
+ *
+ * @param shard  Cache shard (locked).
+ * @param entry  Cache entry.
+ */
+static void
+discard_entry(struct cache_shard *shard, struct cache_entry *entry)
+{
+	unsigned idx;
+
+	entry->busy = false;
+	wake_waiters(shard);
+	if (--entry->refcnt)
+		return;
+	--shard->nheld;
+	if (cache_entry_valid(entry))
+		return;
+	if (entry->state == cs_probe)
+		--shard->nprobetotal;
+
+	idx = entry - shard->ce;
+	if (shard->ninflight--) {
+		if (shard->inflight == idx)
+			shard->inflight = entry->next;
+		remove_entry(shard, entry);
+	}
+
+	hash_remove(shard, idx);
+	add_unused(shard, entry, idx, find_lruprobe(shard));
 }
 
 /**  Discard an entry.
@@ -638,134 +1605,486 @@ cache_put_entry(struct cache *cache, struct cache_entry *entry)
 void
 cache_discard(struct cache *cache, struct cache_entry *entry)
 {
-	unsigned n, idx, eprobe;
+	struct cache_shard *shard = key_shard(cache, entry->key);
 
-	if (--entry->refcnt)
-		return;
-	if (cache_entry_valid(entry))
+	mutex_lock(&shard->mutex);
+	discard_entry(shard, entry);
+	mutex_unlock(&shard->mutex);
+}
+
+/**  Get multiple cache entries.
+ *
+ * @param cache    Cache object.
+ * @param keys     Keys to be searched.
+ * @param entries  Resulting entries (filled in).
+ * @param n        Number of keys (at most @ref CACHE_BATCH_MAX).
+ *
+ * This function works like calling @ref cache_get_entry for each key,
+ * but each shard is locked only once. It never blocks, and it never
+ * returns an entry which is being loaded by another thread. If a shard
+ * is full or if the data for a key is being loaded, the corresponding
+ * element of @p entries is set to @c NULL.
+ *
+ * In-flight entries must be either inserted and released, or discarded,
+ * just like entries returned by @ref cache_get_entry.
+ */
+void
+cache_get_entries(struct cache *cache, const cache_key_t *keys,
+		  struct cache_entry **entries, unsigned n)
+{
+	struct cache_shard *shard;
+	struct cache_entry *entry;
+	unsigned long todo;
+	unsigned i, j;
+
+	todo = (1UL << n) - 1;
+	for (i = 0; i < n; ++i) {
+		if (!(todo & (1UL << i)))
+			continue;
+
+		shard = key_shard(cache, keys[i]);
+		mutex_lock(&shard->mutex);
+		for (j = i; j < n; ++j) {
+			if (!(todo & (1UL << j)) ||
+			    key_shard(cache, keys[j]) != shard)
+				continue;
+			todo &= ~(1UL << j);
+
+			entry = cache_get_entry_noref(shard, keys[j]);
+			if (!entry)
+				++shard->busy;
+			else if (!entry_ready(entry))
+				entry = NULL;
+			else {
+				hold_entry(shard, entry);
+				use_readahead_entry(shard, entry);
+				if (!cache_entry_valid(entry))
+					entry->busy = true;
+			}
+			entries[j] = entry;
+		}
+		if (shard->cap < shard->maxcap)
+			adapt_shard(shard);
+		mutex_unlock(&shard->mutex);
+	}
+}
+
+/**  Insert multiple entries into the cache.
+ *
+ * @param cache    Cache object.
+ * @param entries  Cache entries (with data); @c NULL elements are skipped.
+ * @param n        Number of entries (at most @ref CACHE_BATCH_MAX).
+ *
+ * This function works like calling @ref cache_insert for each entry,
+ * but each shard is locked only once.
+ */
+void
+cache_insert_entries(struct cache *cache, struct cache_entry **entries,
+		     unsigned n)
+{
+	struct cache_shard *shard;
+	unsigned long todo;
+	unsigned i, j;
+
+	todo = 0;
+	for (i = 0; i < n; ++i)
+		if (entries[i])
+			todo |= 1UL << i;
+
+	for (i = 0; i < n; ++i) {
+		if (!(todo & (1UL << i)))
+			continue;
+
+		shard = key_shard(cache, entries[i]->key);
+		mutex_lock(&shard->mutex);
+		for (j = i; j < n; ++j) {
+			if (!(todo & (1UL << j)) ||
+			    key_shard(cache, entries[j]->key) != shard)
+				continue;
+			todo &= ~(1UL << j);
+			insert_entry(shard, entries[j]);
+		}
+		mutex_unlock(&shard->mutex);
+	}
+}
+
+/**  Drop references to multiple cache entries.
+ *
+ * @param cache    Cache object.
+ * @param entries  Cache entries; @c NULL elements are skipped.
+ * @param n        Number of entries (at most @ref CACHE_BATCH_MAX).
+ *
+ * This function works like calling @ref cache_put_entry for each entry,
+ * but each shard is locked only once.
+ */
+void
+cache_put_entries(struct cache *cache, struct cache_entry **entries,
+		  unsigned n)
+{
+	struct cache_shard *shard;
+	unsigned long todo;
+	unsigned i, j;
+	bool wake;
+
+	todo = 0;
+	for (i = 0; i < n; ++i)
+		if (entries[i])
+			todo |= 1UL << i;
+
+	for (i = 0; i < n; ++i) {
+		if (!(todo & (1UL << i)))
+			continue;
+
+		shard = key_shard(cache, entries[i]->key);
+		wake = false;
+		mutex_lock(&shard->mutex);
+		for (j = i; j < n; ++j) {
+			if (!(todo & (1UL << j)) ||
+			    key_shard(cache, entries[j]->key) != shard)
+				continue;
+			todo &= ~(1UL << j);
+			if (!--entries[j]->refcnt) {
+				--shard->nheld;
+				wake = true;
+			}
+		}
+		if (wake)
+			wake_waiters(shard);
+		mutex_unlock(&shard->mutex);
+	}
+}
+
+/**  Clean up all entries in a cache shard.
+ *
+ * @param shard  Cache shard.
+ *
+ * Call the entry destructor on all active entries in the shard.
+ */
+static void
+cleanup_entries(struct cache_shard *shard)
+{
+	struct cache *cache = shard->cache;
+	unsigned n, idx;
+	struct cache_entry *entry;
+
+	if (!cache->entry_cleanup)
 		return;
-	if (entry->state == cs_probe)
-		--cache->nprobetotal;
 
-	idx = entry - cache->ce;
-	if (cache->ninflight--) {
-		if (cache->inflight == idx)
-			cache->inflight = entry->next;
-		remove_entry(cache, entry);
+	/* Clean up precious entries */
+	n = shard->nprec;
+	idx = shard->ce[shard->split].next;
+	while (n--) {
+		entry = &shard->ce[idx];
+		cache->entry_cleanup(cache->cleanup_data, entry);
+		idx = entry->next;
 	}
 
-	n = cache->nprobe + cache->ngprobe;
-	eprobe = cache->split;
-	while (n--)
-		eprobe = cache->ce[eprobe].prev;
+	/* Clean up probed entries */
+	n = shard->nprobe;
+	idx = shard->split;
+	while (n--) {
+		entry = &shard->ce[idx];
+		cache->entry_cleanup(cache->cleanup_data, entry);
+		idx = entry->prev;
+	}
+}
+
+/**  Flush all entries in a cache shard.
+ *
+ * @param shard  Cache shard (locked).
+ */
+static void
+flush_shard(struct cache_shard *shard)
+{
+	struct cache_chunk *chunk;
+	unsigned i, n;
+
+	cleanup_entries(shard);
+
+	for (chunk = shard->chunks; chunk; chunk = chunk->next)
+		chunk->nfree = chunk->n;
+	shard->nspare = shard->cap;
+
+	n = 2 * shard->cap;
+	for (i = 0; i < n; ++i) {
+		struct cache_entry *entry = &shard->ce[i];
+		entry->next = (i > 0) ? (i - 1) : (n - 1);
+		entry->prev = (i < n - 1) ? (i + 1) : 0;
+		entry->refcnt = 0;
+		entry->busy = false;
+		entry->data = i < shard->cap
+			? take_spare(shard)
+			: NULL;
+	}
+
+	memset(shard->hash, 0xff, sizeof(unsigned) << shard->hash_bits);
+
+	shard->split = 0;
+	shard->nprec = 0;
+	shard->ngprec = 0;
+	shard->nprobe = 0;
+	shard->ngprobe = 0;
+	shard->dprobe = 0;
+	shard->nprobetotal = 0;
+	shard->ninflight = 0;
+	shard->nheld = 0;
+}
 
-	if (eprobe == cache->split)
-		cache->split = idx;
+/**  Flush all cache entries.
+ *
+ * @param cache  Cache object.
+ */
+void
+cache_flush(struct cache *cache)
+{
+	unsigned i;
+
+	for (i = 0; i < cache_nshards(cache); ++i) {
+		struct cache_shard *shard = cache->shard[i];
+		mutex_lock(&shard->mutex);
+		flush_shard(shard);
+		mutex_unlock(&shard->mutex);
+	}
+}
+
+/**  Free all shards of a cache object.
+ *
+ * @param cache  Cache object.
+ * @param n      Number of allocated shards.
+ */
+static void
+free_shards(struct cache *cache, unsigned n)
+{
+	while (n--) {
+		struct cache_shard *shard = cache->shard[n];
+		struct cache_chunk *chunk, *next;
 
-	add_entry_after(cache, entry, idx, eprobe);
+		for (chunk = shard->chunks; chunk; chunk = next) {
+			next = chunk->next;
+			free(chunk);
+		}
+		cond_destroy(&shard->cond);
+		mutex_destroy(&shard->mutex);
+		free(shard);
+	}
 }
 
-/**  Clean up all cache entries.
+/**  Scale a cache.
  *
- * @param cache  Cache object.
+ * @param cache   Cache object.
+ * @param factor  Scaling factor.
  *
- * Call the entry destructor on all active entries in the cache.
+ * Grow each shard to @p factor times its initial capacity, but not
+ * beyond its maximum capacity. A cache never shrinks.
  */
-static void
-cleanup_entries(struct cache *cache)
+void
+cache_scale(struct cache *cache, unsigned factor)
 {
-	unsigned n, idx;
-	struct cache_entry *entry;
+	unsigned i;
 
-	if (!cache->entry_cleanup)
-		return;
-
-	/* Clean up precious entries */
-	n = cache->nprec;
-	idx = cache->ce[cache->split].next;
-	while (n--) {
-		entry = &cache->ce[idx];
-		cache->entry_cleanup(cache->cleanup_data, entry);
-		idx = entry->next;
-	}
+	for (i = 0; i < cache_nshards(cache); ++i) {
+		struct cache_shard *shard = cache->shard[i];
+		unsigned n = shard->maxcap;
 
-	/* Clean up probed entries */
-	n = cache->nprobe;
-	idx = cache->split;
-	while (n--) {
-		entry = &cache->ce[idx];
-		cache->entry_cleanup(cache->cleanup_data, entry);
-		idx = entry->prev;
+		if (shard->basecap && factor < n / shard->basecap)
+			n = shard->basecap * factor;
+		mutex_lock(&shard->mutex);
+		grow_shard(shard, n);
+		mutex_unlock(&shard->mutex);
 	}
 }
 
-/**  Flush all cache entries.
+/**  Choose the number of shards for a cache.
  *
- * @param cache  Cache object.
+ * @param n  Total number of elements in the cache.
+ * @returns  Number of shards as a power of two.
  */
-void
-cache_flush(struct cache *cache)
+static unsigned
+choose_shard_bits(unsigned n)
 {
-	unsigned i, n;
+	unsigned bits = 0;
 
-	cleanup_entries(cache);
+	while (bits < CACHE_SHARD_BITS_MAX &&
+	       (n >> (bits + 1)) >= CACHE_SHARD_MIN)
+		++bits;
+	return bits;
+}
 
-	n = 2 * cache->cap;
-	for (i = 0; i < n; ++i) {
-		struct cache_entry *entry = &cache->ce[i];
-		entry->next = (i > 0) ? (i - 1) : (n - 1);
-		entry->prev = (i < n - 1) ? (i + 1) : 0;
-		entry->refcnt = 0;
-		entry->data = i < cache->cap
-			? cache->data + i * cache->elemsize
-			: NULL;
-	}
+/**  Get the share of a cache shard.
+ *
+ * @param n     Total number of elements.
+ * @param bits  Number of shards as a power of two.
+ * @param i     Shard index.
+ * @returns     Number of elements in shard @p i.
+ */
+static inline unsigned
+shard_share(unsigned n, unsigned bits, unsigned i)
+{
+	return (n >> bits) + (i < (n & ((1U << bits) - 1)));
+}
+
+/**  Choose the size of a hash index.
+ *
+ * @param n  Maximum number of entries in the index.
+ * @returns  Number of slots as a power of two.
+ *
+ * The index is kept at most half full, so that probe sequences are short.
+ */
+static unsigned
+hash_index_bits(unsigned n)
+{
+	unsigned bits = CACHE_HASH_BITS_MIN;
 
-	cache->split = 0;
-	cache->nprec = 0;
-	cache->ngprec = 0;
-	cache->nprobe = 0;
-	cache->ngprobe = 0;
-	cache->dprobe = 0;
-	cache->nprobetotal = 0;
-	cache->ninflight = 0;
+	while ((1UL << bits) < 2UL * n)
+		++bits;
+	return bits;
 }
 
 /**  Allocate a cache object.
  *
  * @param n     Number of elements in the cache.
+ * @param max   Maximum number of elements in the cache.
  * @param size  Data size for each element.
+ * @param huge  Try to back element data with huge pages.
  * @returns     Newly allocated cache object, or @c NULL on failure.
  *
+ * The cache initially holds @p n elements. It may grow up to @p max
+ * elements; if @p max is less than @p n, the cache does not grow.
+ * Only the entry bookkeeping is allocated for @p max elements; data
+ * is allocated as the cache grows.
+ *
+ * If @p huge is @c true and huge pages are available, data for @p max
+ * elements is mapped at once; use @ref cache_data_mode to find out
+ * whether that was the case.
+ *
  * The reference count of the new cache object is set to 1.
  */
 struct cache *
-cache_alloc(unsigned n, size_t size)
+cache_alloc(unsigned n, unsigned max, size_t size, bool huge)
+{
+	return cache_alloc_node(n, max, size, huge, NULL, 0);
+}
+
+/**  Allocate a cache object on a NUMA node.
+ *
+ * @param n     Number of elements in the cache.
+ * @param max   Maximum number of elements in the cache.
+ * @param size  Data size for each element.
+ * @param huge  Try to back element data with huge pages.
+ * @param numa  NUMA topology, or @c NULL.
+ * @param node  Node index (ignored if @p numa is @c NULL).
+ * @returns     Newly allocated cache object, or @c NULL on failure.
+ *
+ * This function works like @ref cache_alloc, but if @p numa is
+ * non-NULL, data for @p max elements is always mapped at once, and
+ * its memory is placed on @p node.
+ */
+struct cache *
+cache_alloc_node(unsigned n, unsigned max, size_t size, bool huge,
+		 const struct numa_topology *numa, unsigned node)
 {
 	struct cache *cache;
+	char *pool;
+	unsigned bits, i;
+
+	if (max < n)
+		max = n;
 
+	bits = choose_shard_bits(n);
 	cache = malloc(sizeof(struct cache) +
-		       2 * n * sizeof(struct cache_entry));
+		       (sizeof(struct cache_shard *) << bits));
 	if (!cache)
 		return cache;
 
+	cache->shard_bits = bits;
 	cache->elemsize = size;
-	cache->cap = n;
+	cache->wait = false;
 	cache->hits.number = 0;
 	cache->misses.number = 0;
+	cache->ghost_hits.number = 0;
+	cache->evictions.number = 0;
+	cache->busy.number = 0;
+	cache->inflight_max.number = 0;
+	cache->waits.number = 0;
+	cache->wait_time.number = 0;
+	cache->capacity.number = n;
+	cache->bytes_used.number = (kdump_num_t)n * size;
 	cache->entry_cleanup = NULL;
 
-	if (cache->elemsize) {
-		cache->data = malloc(cache->cap * cache->elemsize);
-		if (!cache->data) {
-			free(cache);
-			return NULL;
+	if (numa && size) {
+		if (!node_area_alloc(&cache->pool, (size_t)max * size,
+				     huge, numa, node))
+			cache->pool.ptr = NULL;
+	} else if (!huge || !size ||
+		   !huge_area_alloc(&cache->pool, (size_t)max * size))
+		cache->pool.ptr = NULL;
+	pool = cache->pool.ptr;
+
+	for (i = 0; i < cache_nshards(cache); ++i) {
+		struct cache_shard *shard;
+		unsigned cap = shard_share(n, bits, i);
+		unsigned maxcap = shard_share(max, bits, i);
+		unsigned hash_bits = hash_index_bits(2 * maxcap);
+
+		shard = malloc(sizeof(struct cache_shard) +
+			       2 * maxcap * sizeof(struct cache_entry) +
+			       (sizeof(unsigned) << hash_bits));
+		if (!shard)
+			goto err;
+		shard->hash_bits = hash_bits;
+		shard->hash = (unsigned *)&shard->ce[2 * maxcap];
+		shard->cache = cache;
+		shard->policy = &cache_policies[0];
+		shard->pool = pool;
+		if (pool)
+			pool += (size_t)maxcap * size;
+		shard->chunks = alloc_chunk(shard, cap);
+		if (!shard->chunks) {
+			free(shard);
+			goto err;
+		}
+		shard->chunks->next = NULL;
+		if (mutex_init(&shard->mutex, NULL)) {
+			free(shard->chunks);
+			free(shard);
+			goto err;
+		}
+		if (cond_init(&shard->cond, NULL)) {
+			mutex_destroy(&shard->mutex);
+			free(shard->chunks);
+			free(shard);
+			goto err;
 		}
-	} else
-		cache->data = cache; /* Any non-NULL pointer */
 
-	cache_flush(cache);
+		shard->nwaiters = 0;
+		shard->cap = cap;
+		shard->basecap = cap;
+		shard->maxcap = maxcap;
+		shard->hits = 0;
+		shard->misses = 0;
+		shard->ghost_hits = 0;
+		shard->evictions = 0;
+		shard->busy = 0;
+		shard->inflight_max = 0;
+		shard->waits = 0;
+		shard->wait_time = 0;
+		shard->ra_loads = 0;
+		shard->ra_hits = 0;
+		shard->adapt_lookups = 0;
+		shard->adapt_ghosts = 0;
+
+		flush_shard(shard);
+		cache->shard[i] = shard;
+	}
+
 	return cache;
+
+ err:
+	free_shards(cache, i);
+	if (cache->pool.ptr)
+		data_area_free(&cache->pool);
+	free(cache);
+	return NULL;
 }
 
 /** Set cache entry destructor.
@@ -796,12 +2115,201 @@ set_cache_entry_cleanup(struct cache *cache, cache_entry_cleanup_fn *fn,
 void
 cache_free(struct cache *cache)
 {
-	cleanup_entries(cache);
-	if (cache->data != cache)
-		free(cache->data);
+	unsigned i;
+
+	for (i = 0; i < cache_nshards(cache); ++i)
+		cleanup_entries(cache->shard[i]);
+	free_shards(cache, cache_nshards(cache));
+	if (cache->pool.ptr)
+		data_area_free(&cache->pool);
 	free(cache);
 }
 
+/**  Get the backing memory type of cache data.
+ * @param cache  Cache object.
+ * @returns      Backing memory type.
+ */
+enum data_mode
+cache_data_mode(const struct cache *cache)
+{
+	return cache->pool.ptr ? cache->pool.mode : dm_malloc;
+}
+
+/**  Set cache wait mode.
+ * @param cache  Cache object.
+ * @param wait   @c true if @ref cache_get_entry should block instead of
+ *               failing when no entry is available.
+ */
+void
+cache_set_wait(struct cache *cache, bool wait)
+{
+	cache->wait = wait;
+}
+
+/**  Set the cache replacement policy.
+ * @param cache  Cache object.
+ * @param name   Policy name.
+ * @returns      @c true on success, @c false if @p name is unknown.
+ *
+ * Entries which are already cached are kept. They are moved or evicted
+ * according to the new policy from now on.
+ */
+bool
+cache_set_policy(struct cache *cache, const char *name)
+{
+	const struct cache_policy *policy;
+	unsigned i;
+
+	for (policy = cache_policies;
+	     policy < &cache_policies[ARRAY_SIZE(cache_policies)];
+	     ++policy)
+		if (!strcmp(policy->name, name))
+			break;
+	if (policy == &cache_policies[ARRAY_SIZE(cache_policies)])
+		return false;
+
+	for (i = 0; i < cache_nshards(cache); ++i) {
+		struct cache_shard *shard = cache->shard[i];
+		mutex_lock(&shard->mutex);
+		shard->policy = policy;
+		mutex_unlock(&shard->mutex);
+	}
+	return true;
+}
+
+/**  Get the current capacity of a cache.
+ * @param cache  Cache object.
+ * @returns      Total number of data slots in all shards.
+ */
+unsigned
+cache_capacity(struct cache *cache)
+{
+	unsigned i, cap = 0;
+
+	for (i = 0; i < cache_nshards(cache); ++i) {
+		struct cache_shard *shard = cache->shard[i];
+		mutex_lock(&shard->mutex);
+		cap += shard->cap;
+		mutex_unlock(&shard->mutex);
+	}
+	return cap;
+}
+
+/**  Update cache statistics.
+ * @param cache  Cache object.
+ *
+ * Sum up the counters of all shards and store the result in the cache
+ * object. The in-flight high-water mark is the maximum over all shards,
+ * because each shard runs out of entries independently.
+ */
+void
+cache_update_stats(struct cache *cache)
+{
+	unsigned long hits = 0, misses = 0, ghost_hits = 0;
+	unsigned long evictions = 0, busy = 0, waits = 0;
+	unsigned long ra_loads = 0, ra_hits = 0;
+	kdump_num_t wait_time = 0;
+	unsigned i, cap = 0, inflight_max = 0;
+
+	for (i = 0; i < cache_nshards(cache); ++i) {
+		struct cache_shard *shard = cache->shard[i];
+		mutex_lock(&shard->mutex);
+		hits += shard->hits;
+		misses += shard->misses;
+		ghost_hits += shard->ghost_hits;
+		evictions += shard->evictions;
+		busy += shard->busy;
+		if (shard->inflight_max > inflight_max)
+			inflight_max = shard->inflight_max;
+		waits += shard->waits;
+		wait_time += shard->wait_time;
+		ra_loads += shard->ra_loads;
+		ra_hits += shard->ra_hits;
+		cap += shard->cap;
+		mutex_unlock(&shard->mutex);
+	}
+
+	cache->hits.number = hits;
+	cache->misses.number = misses;
+	cache->ghost_hits.number = ghost_hits;
+	cache->evictions.number = evictions;
+	cache->busy.number = busy;
+	cache->inflight_max.number = inflight_max;
+	cache->waits.number = waits;
+	cache->wait_time.number = wait_time;
+	cache->readahead_loads.number = ra_loads;
+	cache->readahead_hits.number = ra_hits;
+	cache->capacity.number = cap;
+	cache->bytes_used.number = (kdump_num_t)cap * cache->elemsize;
+}
+
+/**  Add statistics of another cache.
+ * @param dst  Cache object which receives the sums.
+ * @param src  Cache object with up-to-date statistics.
+ *
+ * Both caches must have been updated with @ref cache_update_stats.
+ */
+static void
+cache_add_stats(struct cache *dst, const struct cache *src)
+{
+	dst->hits.number += src->hits.number;
+	dst->misses.number += src->misses.number;
+	dst->ghost_hits.number += src->ghost_hits.number;
+	dst->evictions.number += src->evictions.number;
+	dst->busy.number += src->busy.number;
+	if (src->inflight_max.number > dst->inflight_max.number)
+		dst->inflight_max.number = src->inflight_max.number;
+	dst->waits.number += src->waits.number;
+	dst->wait_time.number += src->wait_time.number;
+	dst->readahead_loads.number += src->readahead_loads.number;
+	dst->readahead_hits.number += src->readahead_hits.number;
+	dst->capacity.number += src->capacity.number;
+	dst->bytes_used.number += src->bytes_used.number;
+}
+
+/**  Bind cache statistics to attributes.
+ * @param cache  Cache object.
+ * @param ctx    Dump file object.
+ * @param dir    Attribute directory.
+ *
+ * Each statistics counter is bound to the attribute of the same name
+ * in @p dir (if there is one). The attribute values are updated by
+ * @ref cache_update_stats.
+ */
+void
+cache_set_attrs(struct cache *cache, kdump_ctx_t *ctx, struct attr_data *dir)
+{
+	static const struct {
+		const char *key;
+		size_t off;
+	} stats[] = {
+#define STAT(name)	{ #name, offsetof(struct cache, name) }
+		STAT(hits),
+		STAT(misses),
+		STAT(ghost_hits),
+		STAT(evictions),
+		STAT(busy),
+		STAT(inflight_max),
+		STAT(waits),
+		STAT(wait_time),
+		STAT(readahead_loads),
+		STAT(readahead_hits),
+		STAT(capacity),
+		STAT(bytes_used),
+#undef STAT
+	};
+	struct attr_data *attr;
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(stats); ++i) {
+		attr = lookup_dir_attr(ctx->dict, dir, stats[i].key,
+				       strlen(stats[i].key));
+		if (attr)
+			set_attr(ctx, attr, ATTR_INDIRECT,
+				 (void*)cache + stats[i].off);
+	}
+}
+
 /**  Get the configured cache size.
  * @param ctx  Dump file object.
  * @returns    Cache size.
@@ -818,38 +2326,307 @@ get_cache_size(kdump_ctx_t *ctx)
 		: DEFAULT_CACHE_SIZE;
 }
 
+/**  Get the configured cache wait mode.
+ * @param ctx  Dump file object.
+ * @returns    @c true if readers should wait for busy cache entries.
+ *
+ * Get the wait mode from "cache.wait" attribute. If not set, return
+ * @c false.
+ */
+bool
+get_cache_wait(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_cache_wait);
+	return attr_isset(attr) && attr_revalidate(ctx, attr) == KDUMP_OK
+		? !!attr_value(attr)->number
+		: false;
+}
+
+/**  Get the configured huge page mode.
+ * @param ctx  Dump file object.
+ * @returns    @c true if cache data should be backed by huge pages.
+ *
+ * Get the mode from "cache.hugepages" attribute. If not set, return
+ * @c false.
+ */
+bool
+get_cache_hugepages(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_cache_hugepages);
+	return attr_isset(attr) && attr_revalidate(ctx, attr) == KDUMP_OK
+		? !!attr_value(attr)->number
+		: false;
+}
+
+/**  Get the configured NUMA mode.
+ * @param ctx  Dump file object.
+ * @returns    @c true if the cache should be partitioned by NUMA nodes.
+ *
+ * Get the mode from "cache.numa.enabled" attribute. If not set, return
+ * @c false.
+ */
+bool
+get_cache_numa(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_cache_numa_enabled);
+	return attr_isset(attr) && attr_revalidate(ctx, attr) == KDUMP_OK
+		? !!attr_value(attr)->number
+		: false;
+}
+
+/**  Get the configured cache replacement policy.
+ * @param ctx  Dump file object.
+ * @returns    Policy name, or @c NULL for the default policy.
+ *
+ * Get the policy from "cache.policy" attribute.
+ */
+const char *
+get_cache_policy(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_cache_policy);
+	return attr_isset(attr) && attr_revalidate(ctx, attr) == KDUMP_OK
+		? attr_value(attr)->string
+		: NULL;
+}
+
+/**  Get the maximum cache size.
+ * @param ctx  Dump file object.
+ * @returns    Maximum number of cache elements.
+ *
+ * Get the memory ceiling from "cache.max_bytes" attribute and convert
+ * it to a number of pages. If not set, return zero.
+ */
+unsigned
+get_cache_max_size(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_cache_max_bytes);
+	kdump_num_t max;
+
+	if (!attr_isset(attr) || attr_revalidate(ctx, attr) != KDUMP_OK)
+		return 0;
+	max = attr_value(attr)->number / get_page_size(ctx);
+	return max < UINT_MAX ? max : UINT_MAX;
+}
+
+/**  Get the cache memory budget.
+ * @param ctx  Dump file object.
+ * @returns    Memory budget in bytes, or zero if unlimited.
+ *
+ * Get the budget from "cache.budget" attribute. If not set, return zero.
+ */
+kdump_num_t
+get_cache_budget(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_cache_budget);
+	return attr_isset(attr) && attr_revalidate(ctx, attr) == KDUMP_OK
+		? attr_value(attr)->number
+		: 0;
+}
+
+/**  Get the maximum number of pages which fit into the cache budget.
+ * @param ctx     Dump file object.
+ * @param budget  Memory budget in bytes (non-zero).
+ * @returns       Number of pages for the page cache (at least one).
+ *
+ * The share of the file cache (see @ref FCACHE_BUDGET_SHIFT) is
+ * subtracted from the budget.
+ */
+static unsigned
+budget_pages(kdump_ctx_t *ctx, kdump_num_t budget)
+{
+	kdump_num_t n;
+
+	n = (budget - (budget >> FCACHE_BUDGET_SHIFT)) / get_page_size(ctx);
+	if (n > UINT_MAX)
+		return UINT_MAX;
+	return n ? n : 1;
+}
+
+/**  Get all page cache partitions.
+ * @param      shared  Shared data of a dump file object.
+ * @param[out] pn      Number of partitions.
+ * @returns            Array of partitions.
+ *
+ * If the page cache is not partitioned, its only partition is the
+ * page cache itself. If there is no page cache, @p pn is set to zero.
+ */
+static struct cache **
+page_caches(struct kdump_shared *shared, unsigned *pn)
+{
+	if (shared->node_cache) {
+		*pn = shared->numa->nnodes;
+		return shared->node_cache;
+	}
+	*pn = !!shared->cache;
+	return &shared->cache;
+}
+
+/**  Free page cache partitions.
+ * @param node_cache  Array of partitions.
+ * @param n           Number of partitions.
+ */
+static void
+free_partitions(struct cache **node_cache, unsigned n)
+{
+	while (n--)
+		cache_free(node_cache[n]);
+	free(node_cache);
+}
+
+/**  Free the page cache of a dump file.
+ * @param shared  Shared data of a dump file object.
+ *
+ * All partitions of the page cache are freed.
+ */
+void
+free_page_caches(struct kdump_shared *shared)
+{
+	if (shared->node_cache) {
+		free_partitions(shared->node_cache, shared->numa->nnodes);
+		numa_topology_free(shared->numa);
+		shared->node_cache = NULL;
+		shared->numa = NULL;
+	} else if (shared->cache)
+		cache_free(shared->cache);
+	shared->cache = NULL;
+}
+
+/**  Scale shared caches with the number of dump file objects.
+ * @param shared  Shared data of a dump file object (write-locked).
+ *
+ * Each clone of a dump file object is expected to run in a separate
+ * thread, so all caches grow by their initial size for every clone
+ * (up to their maximum size).
+ */
+void
+scale_caches(struct kdump_shared *shared)
+{
+	struct list_head *node;
+	struct cache **caches;
+	unsigned i, ncaches, n = 0;
+
+	list_for_each(node, &shared->ctx)
+		++n;
+
+	caches = page_caches(shared, &ncaches);
+	for (i = 0; i < ncaches; ++i)
+		cache_scale(caches[i], n);
+	if (shared->fcache)
+		fcache_scale(shared->fcache, n);
+}
+
 /**  Re-allocate a cache with default parameters.
  * @param ctx  Dump file object.
  * @returns    Error status.
  *
  * This function can be used as the @c realloc_caches method if
  * the cache is organized as @c cache.size elements of @c arch.page_size
- * bytes each.
+ * bytes each. The cache may grow up to @c cache.max_bytes.
+ *
+ * If @c cache.budget is set, both the initial and the maximum size are
+ * limited by the budget. If @c cache.max_bytes is not set, the cache
+ * may grow up to the budget.
+ *
+ * If @c cache.hugepages is set, cache data is backed by huge pages
+ * if possible. The actual backing is stored in @c cache.data_mode.
+ *
+ * If @c cache.numa.enabled is set, a separate cache partition of the
+ * same size is allocated for each NUMA node, and the budget is split
+ * evenly between them. The number of partitions is stored in
+ * @c cache.numa.nodes.
+ *
+ * The replacement policy is taken from @c cache.policy.
  */
 kdump_status
 def_realloc_caches(kdump_ctx_t *ctx)
 {
 	unsigned cache_size = get_cache_size(ctx);
+	unsigned max_size = get_cache_max_size(ctx);
+	kdump_num_t budget = get_cache_budget(ctx);
+	const char *policy = get_cache_policy(ctx);
+	bool huge = get_cache_hugepages(ctx);
+	struct numa_topology *numa = NULL;
+	struct cache **node_cache = NULL;
 	struct cache *cache;
+	unsigned i, nnodes = 1;
+	kdump_status status;
+
+	status = check_unpinned(ctx);
+	if (status != KDUMP_OK)
+		return status;
+
+	if (get_cache_numa(ctx)) {
+		numa = numa_topology_read();
+		if (numa) {
+			nnodes = numa->nnodes;
+			node_cache = calloc(nnodes, sizeof(*node_cache));
+			if (!node_cache) {
+				numa_topology_free(numa);
+				return set_error(ctx, KDUMP_ERR_SYSTEM,
+						 "Cannot allocate %u cache partitions",
+						 nnodes);
+			}
+		}
+	}
 
-	cache = cache_alloc(cache_size, get_page_size(ctx));
-	if (!cache)
-		return set_error(ctx, KDUMP_ERR_SYSTEM,
-				 "Cannot allocate cache (%u * %zu bytes)",
-				 cache_size, get_page_size(ctx));
-
-	set_attr(ctx, gattr(ctx, GKI_cache_hits),
-		 ATTR_INDIRECT, &cache->hits);
-	set_attr(ctx, gattr(ctx, GKI_cache_misses),
-		 ATTR_INDIRECT, &cache->misses);
+	if (budget) {
+		unsigned limit = budget_pages(ctx, budget) / nnodes;
+		if (!limit)
+			limit = 1;
+		if (cache_size > limit)
+			cache_size = limit;
+		if (!max_size || max_size > limit)
+			max_size = limit;
+	}
 
-	if (ctx->shared->cache)
-		cache_free(ctx->shared->cache);
+	for (i = 0; i < nnodes; ++i) {
+		cache = cache_alloc_node(cache_size, max_size,
+					 get_page_size(ctx), huge, numa, i);
+		if (!cache) {
+			if (numa) {
+				free_partitions(node_cache, i);
+				numa_topology_free(numa);
+			}
+			return set_error(ctx, KDUMP_ERR_SYSTEM,
+					 "Cannot allocate cache (%u * %zu bytes)",
+					 cache_size, get_page_size(ctx));
+		}
+		cache_set_wait(cache, get_cache_wait(ctx));
+		if (policy)
+			cache_set_policy(cache, policy);
+		if (node_cache)
+			node_cache[i] = cache;
+	}
+	if (node_cache)
+		cache = node_cache[0];
+
+	cache_set_attrs(cache, ctx, gattr(ctx, GKI_dir_cache));
+	set_attr_static_string(ctx, gattr(ctx, GKI_cache_data_mode),
+			       ATTR_DEFAULT,
+			       data_mode_name(cache_data_mode(cache)));
+	set_attr_number(ctx, gattr(ctx, GKI_cache_numa_nodes),
+			ATTR_DEFAULT, numa ? nnodes : 0);
+
+	if (ctx->shared->cache) {
+		cached_reads_flush(ctx->shared);
+		l1_flush(ctx->shared);
+		free_page_caches(ctx->shared);
+	}
 	ctx->shared->cache = cache;
+	ctx->shared->node_cache = node_cache;
+	ctx->shared->numa = numa;
+	scale_caches(ctx->shared);
 
 	return KDUMP_OK;
 }
 
+static kdump_status
+cache_limit_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
+		     kdump_attr_value_t *val)
+{
+	return check_unpinned(ctx);
+}
+
 static kdump_status
 cache_size_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
 		    kdump_attr_value_t *val)
@@ -857,7 +2634,7 @@ cache_size_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
 	if (val->number > UINT_MAX)
 		return set_error(ctx, KDUMP_ERR_INVALID,
 				 "Cache size too big (max %u)", UINT_MAX);
-	return KDUMP_OK;
+	return cache_limit_pre_hook(ctx, attr, val);
 }
 
 static kdump_status
@@ -872,3 +2649,104 @@ const struct attr_ops cache_size_ops = {
 	.pre_set = cache_size_pre_hook,
 	.post_set = cache_size_post_hook,
 };
+
+const struct attr_ops cache_limit_ops = {
+	.pre_set = cache_limit_pre_hook,
+	.post_set = cache_size_post_hook,
+};
+
+static kdump_status
+cache_wait_post_hook(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	struct cache **caches;
+	unsigned i, n;
+
+	caches = page_caches(ctx->shared, &n);
+	for (i = 0; i < n; ++i)
+		cache_set_wait(caches[i], !!attr_value(attr)->number);
+	return KDUMP_OK;
+}
+
+const struct attr_ops cache_wait_ops = {
+	.post_set = cache_wait_post_hook,
+};
+
+static kdump_status
+cache_policy_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
+		      kdump_attr_value_t *val)
+{
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(cache_policies); ++i)
+		if (!strcmp(cache_policies[i].name, val->string))
+			return KDUMP_OK;
+	return set_error(ctx, KDUMP_ERR_INVALID,
+			 "Unknown cache policy: %s", val->string);
+}
+
+static kdump_status
+cache_policy_post_hook(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	struct cache **caches;
+	unsigned i, n;
+
+	caches = page_caches(ctx->shared, &n);
+	for (i = 0; i < n; ++i)
+		cache_set_policy(caches[i], attr_value(attr)->string);
+	return KDUMP_OK;
+}
+
+const struct attr_ops cache_policy_ops = {
+	.pre_set = cache_policy_pre_hook,
+	.post_set = cache_policy_post_hook,
+};
+
+static kdump_status
+cache_readahead_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
+			 kdump_attr_value_t *val)
+{
+	if (val->number > UINT_MAX)
+		return set_error(ctx, KDUMP_ERR_INVALID,
+				 "Read-ahead window too big (max %u)",
+				 UINT_MAX);
+	return KDUMP_OK;
+}
+
+const struct attr_ops cache_readahead_ops = {
+	.pre_set = cache_readahead_pre_hook,
+};
+
+static kdump_status
+cache_stats_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	struct cache **caches;
+	unsigned i, n;
+
+	caches = page_caches(ctx->shared, &n);
+	for (i = 0; i < n; ++i) {
+		cache_update_stats(caches[i]);
+		if (i)
+			cache_add_stats(caches[0], caches[i]);
+	}
+	return KDUMP_OK;
+}
+
+/**  Statistics of the page cache.
+ * If the cache is partitioned, the values are summed up over all
+ * partitions.
+ */
+const struct attr_ops cache_stats_ops = {
+	.revalidate = cache_stats_revalidate,
+};
+
+static kdump_status
+fcache_stats_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	if (ctx->shared->fcache)
+		fcache_update_stats(ctx->shared->fcache);
+	return KDUMP_OK;
+}
+
+const struct attr_ops fcache_stats_ops = {
+	.revalidate = fcache_stats_revalidate,
+};
@@ -44,21 +44,18 @@ static kdump_ctx_t *
 alloc_ctx(void)
 {
 	kdump_ctx_t *ctx;
-	unsigned i;
 
 	ctx = calloc(1, sizeof (kdump_ctx_t) + ERRBUF);
 	if (!ctx)
 		return ctx;
 
 	err_init(&ctx->err, ERRBUF);
+	ctx->numa_node = -1;
 
 	ctx->xlatctx = init_addrxlat(ctx);
 	if (!ctx->xlatctx)
 		goto err;
 
-	for (i = 0; i < READ_CACHE_SLOTS; ++i)
-		ctx->cached.key[i] = ADDRXLAT_NOADDR;
-
 	return ctx;
 
  err:
@@ -78,16 +75,12 @@ alloc_shared(void)
 	list_init(&shared->ctx);
 
 	if (rwlock_init(&shared->lock, NULL))
-		goto err1;
-
-	if (mutex_init(&shared->cache_lock, NULL))
-		goto err2;
+		goto err;
 
 	shared->refcnt = 1;
 	return shared;
 
- err2:	rwlock_destroy(&shared->lock);
- err1:	free(shared);
+ err:	free(shared);
 	return NULL;
 }
 
@@ -101,15 +94,17 @@ shared_free(struct kdump_shared *shared)
 {
 	rwlock_unlock(&shared->lock);
 
+	prefetch_free(shared);
+
 	if (shared->ops && shared->ops->cleanup)
 		shared->ops->cleanup(shared);
 	if (shared->arch_ops && shared->arch_ops->cleanup)
 		shared->arch_ops->cleanup(shared);
-	if (shared->cache)
-		cache_free(shared->cache);
+	free_page_caches(shared);
 	if (shared->fcache)
 		fcache_decref(shared->fcache);
-	mutex_destroy(&shared->cache_lock);
+	if (shared->pcache)
+		pcache_free(shared->pcache);
 	rwlock_destroy(&shared->lock);
 	free(shared);
 }
@@ -173,6 +168,22 @@ kdump_new(void)
 
 	set_attr_number(ctx, gattr(ctx, GKI_cache_size),
 			ATTR_PERSIST, DEFAULT_CACHE_SIZE);
+	set_attr_number(ctx, gattr(ctx, GKI_cache_readahead),
+			ATTR_PERSIST, DEFAULT_CACHE_READAHEAD);
+	set_attr_number(ctx, gattr(ctx, GKI_xlat_cache_pages),
+			ATTR_PERSIST, DEFAULT_READ_CACHE_PAGES);
+	set_attr_number(ctx, gattr(ctx, GKI_xlat_cache_hits),
+			ATTR_PERSIST, 0);
+	set_attr_number(ctx, gattr(ctx, GKI_xlat_cache_misses),
+			ATTR_PERSIST, 0);
+	set_attr_number(ctx, gattr(ctx, GKI_cache_l1_pages),
+			ATTR_PERSIST, DEFAULT_L1_PAGES);
+	set_attr_number(ctx, gattr(ctx, GKI_l1_cache_hits),
+			ATTR_PERSIST, 0);
+	set_attr_number(ctx, gattr(ctx, GKI_l1_cache_misses),
+			ATTR_PERSIST, 0);
+	set_attr_number(ctx, gattr(ctx, GKI_numa_remote_hits),
+			ATTR_PERSIST, 0);
 
 	return ctx;
 
@@ -256,6 +267,7 @@ kdump_clone(const kdump_ctx_t *orig, unsigned long flags)
 	}
 	list_add(&ctx->xlat_list, &ctx->xlat->ctx);
 
+	scale_caches(ctx->shared);
 	rwlock_unlock(&orig->shared->lock);
 
 	return ctx;
@@ -310,6 +322,38 @@ kdump_get_addrxlat(kdump_ctx_t *ctx,
 	return status;
 }
 
+/**  Allocate a private dump file object.
+ * @param shared  Dump file shared data.
+ * @returns       Dump file object, or @c NULL on allocation failure.
+ *
+ * The new object is meant for internal threads which call the read
+ * methods of the file format. It is not linked to the list of dump
+ * file objects, it does not hold a reference to @p shared, and it has
+ * neither an attribute dictionary nor address translation. Per-context
+ * data is not allocated.
+ */
+kdump_ctx_t *
+alloc_private_ctx(struct kdump_shared *shared)
+{
+	kdump_ctx_t *ctx;
+
+	ctx = alloc_ctx();
+	if (ctx)
+		ctx->shared = shared;
+	return ctx;
+}
+
+/**  Free a private dump file object.
+ * @param ctx  Dump file object allocated by @ref alloc_private_ctx.
+ */
+void
+free_private_ctx(kdump_ctx_t *ctx)
+{
+	addrxlat_ctx_decref(ctx->xlatctx);
+	err_cleanup(&ctx->err);
+	free(ctx);
+}
+
 /**  Allocate per-context data.
  * @param shared  Dump file shared data.
  * @param sz      Size of per-context data.
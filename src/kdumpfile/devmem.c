@@ -46,6 +46,7 @@
 struct devmem_priv {
 	unsigned cache_size;
 	struct cache_entry *ce;
+	struct data_area data;
 };
 
 static kdump_status
@@ -179,10 +180,8 @@ devmem_get_page(kdump_ctx_t *ctx, struct page_io *pio)
 	++ce->refcnt;
 
 	ce->key = pio->addr.addr;
-	mutex_lock(&ctx->shared->cache_lock);
 	ret = fcache_get_chunk(ctx->shared->fcache, &pio->chunk,
 			       get_page_size(ctx), pio->addr.addr);
-	mutex_unlock(&ctx->shared->cache_lock);
 	if (ret != KDUMP_OK) {
 		--ce->refcnt;
 		return set_error(ctx, ret,
@@ -203,33 +202,46 @@ devmem_realloc_caches(kdump_ctx_t *ctx)
 {
 	struct devmem_priv *dmp = ctx->shared->fmtdata;
 	unsigned cache_size = get_cache_size(ctx);
+	size_t size = (size_t)cache_size * get_page_size(ctx);
 	struct cache_entry *ce;
+	struct data_area data;
+	kdump_status status;
 	unsigned i;
 
+	status = check_unpinned(ctx);
+	if (status != KDUMP_OK)
+		return status;
+
 	ce = calloc(cache_size, sizeof *ce);
 	if (!ce)
 		return set_error(ctx, KDUMP_ERR_SYSTEM,
 				 "Cannot allocate cache (%u * %zu bytes)",
 				 cache_size, sizeof *ce);
 
-	ce[0].data = ctx_malloc(cache_size * get_page_size(ctx),
-				ctx, "cache data");
-	if (!ce[0].data) {
+	if (!data_area_alloc(&data, size, get_cache_hugepages(ctx))) {
 		free(ce);
-		return KDUMP_ERR_SYSTEM;
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot allocate cache data (%zu bytes)",
+				 size);
 	}
 
+	ce[0].data = data.ptr;
 	for (i = 1; i < cache_size; ++i)
 		ce[i].data = ce[i-1].data + get_page_size(ctx);
 
 	dmp->cache_size = cache_size;
 	if (dmp->ce) {
-		free(dmp->ce[0].data);
+		cached_reads_flush(ctx->shared);
+		l1_flush(ctx->shared);
+		data_area_free(&dmp->data);
 		free(dmp->ce);
 	}
 	dmp->ce = ce;
+	dmp->data = data;
 
-	return KDUMP_OK;
+	return set_attr_static_string(ctx, gattr(ctx, GKI_cache_data_mode),
+				      ATTR_DEFAULT,
+				      data_mode_name(data.mode));
 }
 
 static kdump_status
@@ -302,7 +314,7 @@ devmem_cleanup(struct kdump_shared *shared)
 	struct devmem_priv *dmp = shared->fmtdata;
 
 	if (dmp->ce) {
-		free(dmp->ce[0].data);
+		data_area_free(&dmp->data);
 		free(dmp->ce);
 	}
 
@@ -313,6 +325,7 @@ devmem_cleanup(struct kdump_shared *shared)
 const struct format_ops devmem_ops = {
 	.name = "memory",
 	.probe = devmem_probe,
+	.live = true,
 	.get_page = devmem_get_page,
 	.put_page = devmem_put_page,
 	.realloc_caches = devmem_realloc_caches,
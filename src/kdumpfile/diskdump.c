@@ -378,9 +378,7 @@ diskdump_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 		return KDUMP_OK;
 	}
 
-	mutex_lock(&ctx->shared->cache_lock);
 	ret = fcache_pread(ctx->shared->fcache, &pd, sizeof pd, pd_pos);
-	mutex_unlock(&ctx->shared->cache_lock);
 	if (ret != KDUMP_OK)
 		return set_error(ctx, ret,
 				 "Cannot read page descriptor at %llu",
@@ -396,6 +394,8 @@ diskdump_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 			return set_error(ctx, KDUMP_ERR_CORRUPT,
 					 "Wrong compressed size: %lu",
 					 (unsigned long)pd.size);
+		if (pcache_load(ctx, pfn, pio->chunk.data))
+			return KDUMP_OK;
 		buf = ctx->data[ddp->cbuf_slot];
 	} else {
 		if (pd.size != get_page_size(ctx))
@@ -406,9 +406,7 @@ diskdump_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 	}
 
 	/* read page data */
-	mutex_lock(&ctx->shared->cache_lock);
 	ret = fcache_pread(ctx->shared->fcache, buf, pd.size, pd.offset);
-	mutex_unlock(&ctx->shared->cache_lock);
 	if (ret != KDUMP_OK)
 		return set_error(ctx, ret,
 				 "Cannot read page data at %llu",
@@ -458,9 +456,59 @@ diskdump_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 #endif
 	}
 
+	if (pd.flags & DUMP_DH_COMPRESSED)
+		pcache_store(ctx, pfn, pio->chunk.data);
 	return KDUMP_OK;
 }
 
+/** Start reading page descriptors and page data in the background.
+ * @param ctx   Dump file object.
+ * @param addr  Full address of the first page.
+ * @param n     Number of pages.
+ *
+ * Page descriptors of consecutive PFNs are stored next to each other,
+ * and so is usually the page data. Both ranges are passed to the file
+ * cache as a read-ahead hint. The data range is skipped if it is bigger
+ * than the uncompressed pages, because then it is probably not used
+ * only by these pages (e.g. the first page may be a shared zero page).
+ */
+static void
+diskdump_read_ahead(kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr,
+		    unsigned n)
+{
+	struct disk_dump_priv *ddp = ctx->shared->fmtdata;
+	struct fcache *fc = ctx->shared->fcache;
+	kdump_pfn_t pfn, last;
+	struct page_desc first_pd, last_pd;
+	off_t first_pos, last_pos;
+	off_t start, end;
+
+	pfn = addr->addr >> get_page_shift(ctx);
+	if (!n || pfn >= get_max_pfn(ctx))
+		return;
+	last = pfn + n - 1;
+	if (last >= get_max_pfn(ctx) || last < pfn)
+		last = get_max_pfn(ctx) - 1;
+
+	while ((first_pos = pfn_to_pdpos(ddp, pfn)) == (off_t)-1)
+		if (pfn++ == last)
+			return;
+	while ((last_pos = pfn_to_pdpos(ddp, last)) == (off_t)-1)
+		--last;
+
+	fcache_readahead(fc, first_pos,
+			 last_pos + sizeof(struct page_desc) - first_pos);
+
+	if (fcache_pread(fc, &first_pd, sizeof first_pd, first_pos) ||
+	    fcache_pread(fc, &last_pd, sizeof last_pd, last_pos))
+		return;
+	start = dump64toh(ctx, first_pd.offset);
+	end = dump64toh(ctx, last_pd.offset) + dump32toh(ctx, last_pd.size);
+	if (end > start &&
+	    end - start <= (off_t)(last - pfn + 1) * get_page_size(ctx))
+		fcache_readahead(fc, start, end - start);
+}
+
 static kdump_status
 diskdump_get_page(kdump_ctx_t *ctx, struct page_io *pio)
 {
@@ -912,6 +960,10 @@ open_common(kdump_ctx_t *ctx, void *hdr)
 			goto err_cleanup;
 	}
 
+	ret = pcache_open(ctx);
+	if (ret != KDUMP_OK)
+		goto err_cleanup;
+
 	return ret;
 
  err_cleanup:
@@ -974,6 +1026,8 @@ const struct format_ops diskdump_ops = {
 	.probe = diskdump_probe,
 	.get_page = diskdump_get_page,
 	.put_page = cache_put_page,
+	.read_page = diskdump_read_page,
+	.read_ahead = diskdump_read_ahead,
 	.realloc_caches = def_realloc_caches,
 	.attr_cleanup = diskdump_attr_cleanup,
 	.cleanup = diskdump_cleanup,
@@ -231,8 +231,6 @@ elf_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 	size_t size;
 	kdump_status status;
 
-	mutex_lock(&ctx->shared->cache_lock);
-
 	addr = pio->addr.addr;
 	p = pio->chunk.data;
 	endp = p + get_page_size(ctx);
@@ -277,11 +275,9 @@ elf_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 		}
 	}
 
-	mutex_unlock(&ctx->shared->cache_lock);
 	return KDUMP_OK;
 
  err_read:
-	mutex_unlock(&ctx->shared->cache_lock);
 	return set_error(ctx, status,
 			 "Cannot read page data at %llu",
 			 (unsigned long long) pos);
@@ -333,10 +329,8 @@ elf_get_page(kdump_ctx_t *ctx, struct page_io *pio)
 	if (! (loadaddr <= addr && pls->filesz >= addr - loadaddr + sz))
 		return cache_get_page(ctx, pio, elf_read_page);
 
-	mutex_lock(&ctx->shared->cache_lock);
 	status = fcache_get_chunk(ctx->shared->fcache, &pio->chunk, sz,
 				  pls->file_offset + addr - loadaddr);
-	mutex_unlock(&ctx->shared->cache_lock);
 	return status;
 }
 
@@ -744,9 +738,7 @@ xc_p2m_first_step(addrxlat_step_t *step, addrxlat_addr_t addr)
 					"PFN not found");
 
 	pos = edp->xen_map_offset + idx * sizeof(struct xen_p2m);
-	mutex_lock(&shared->cache_lock);
 	status = fcache_pread(shared->fcache, &p2m, sizeof p2m, pos);
-	mutex_unlock(&shared->cache_lock);
 	if (status != KDUMP_OK)
 		return addrxlat_ctx_err(step->ctx, ADDRXLAT_ERR_NODATA,
 					"Cannot read p2m entry at %llu",
@@ -782,9 +774,7 @@ xc_m2p_first_step(addrxlat_step_t *step, addrxlat_addr_t addr)
 					"MFN not found");
 
 	pos = edp->xen_map_offset + idx * sizeof(struct xen_p2m);
-	mutex_lock(&shared->cache_lock);
 	status = fcache_pread(shared->fcache, &p2m, sizeof p2m, pos);
-	mutex_unlock(&shared->cache_lock);
 	if (status != KDUMP_OK)
 		return addrxlat_ctx_err(step->ctx, ADDRXLAT_ERR_NODATA,
 					"Cannot read p2m entry at %llu",
@@ -886,10 +876,8 @@ xc_get_page(kdump_ctx_t *ctx, struct page_io *pio)
 
 	offset = edp->xen_pages_offset + ((off_t)idx << get_page_shift(ctx));
 
-	mutex_lock(&ctx->shared->cache_lock);
 	status = fcache_get_chunk(ctx->shared->fcache, &pio->chunk,
 				  get_page_size(ctx), offset);
-	mutex_unlock(&ctx->shared->cache_lock);
 	return status;
 }
 
@@ -34,11 +34,118 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
 
+/** Maximum growth factor of the file cache.
+ * The file cache grows with the number of threads (see @ref fcache_scale),
+ * but not beyond this multiple of its initial size.
+ */
+#define FCACHE_MAX_SCALE	4
+
+/** Maximum size of an mmap region in an adaptive file cache.
+ * Regions are not enlarged beyond this size, even if the file is
+ * read sequentially.
+ */
+#define FCACHE_ADAPT_MAX_SIZE	((size_t)64 << 20)
+
+/** Number of consecutive region misses needed to change the order.
+ * An adaptive file cache doubles the region size after this many
+ * sequential misses, and halves it (down to the initial size) after
+ * this many non-sequential misses.
+ */
+#define FCACHE_ADAPT_MISSES	4
+
+/** Number of access pattern reports needed to change the advice.
+ * Sequential reports increment a score and random reports decrement
+ * it. The score is clamped to this value in both directions, and the
+ * advice changes when the score reaches either bound, or when it drops
+ * back to zero (see @ref fcache_note_access).
+ */
+#define FCACHE_ADVICE_MISSES	16
+
+/** Maximum number of free chunk buffers kept for reuse.
+ * This should be enough for one buffer of each kind (an entry array
+ * and a bounce buffer) per concurrent reader.
+ */
+#define FCACHE_POOL_BUFS	16
+
+/** Maximum total size of free chunk buffers kept for reuse.
+ * Bigger buffers (e.g. for a whole bitmap, which is read only once)
+ * are freed when they are no longer needed.
+ */
+#define FCACHE_POOL_BYTES	((size_t)4 << 20)
+
+/** Depth of the io_uring submission queue.
+ * This is also the maximum number of pages read with one submission.
+ */
+#define FCACHE_URING_DEPTH	64
+
+/** Get the cache key of an mmap region.
+ * @param fc      File cache object.
+ * @param blkpos  Region start (aligned to the region size).
+ * @param order   Page order of the region.
+ * @returns       Cache key.
+ *
+ * Region start is page-aligned, so the page order can be stored in
+ * the low bits. This way, regions of different sizes never share a
+ * cache entry.
+ */
+static inline cache_key_t
+region_key(const struct fcache *fc, off_t blkpos, unsigned order)
+{
+	return blkpos | order;
+}
+
+/** Get the size of an mmap region from its cache key.
+ * @param fc   File cache object.
+ * @param key  Cache key (see @ref region_key).
+ * @returns    Size of the region in bytes.
+ */
+static inline size_t
+region_size(const struct fcache *fc, cache_key_t key)
+{
+	return fc->pgsz << (key & (fc->pgsz - 1));
+}
+
+/** Chunk buffer.
+ * The buffer data follows this header.
+ */
+struct fcache_buf {
+	/** Next free buffer in the pool. */
+	struct fcache_buf *next;
+
+	/** Size of the buffer data in bytes. */
+	size_t size;
+};
+
+/** Names of access pattern advice values.
+ * These are used by the "fcache.advice" and "fcache.current_advice"
+ * attributes.
+ */
+static const char *const advice_names[] = {
+	[fa_normal] = "normal",
+	[fa_sequential] = "sequential",
+	[fa_random] = "random",
+};
+
+/** posix_fadvise() values for each advice. */
+static const int fadv_values[] = {
+	[fa_normal] = POSIX_FADV_NORMAL,
+	[fa_sequential] = POSIX_FADV_SEQUENTIAL,
+	[fa_random] = POSIX_FADV_RANDOM,
+};
+
+/** madvise() values for each advice. */
+static const int madv_values[] = {
+	[fa_normal] = MADV_NORMAL,
+	[fa_sequential] = MADV_SEQUENTIAL,
+	[fa_random] = MADV_RANDOM,
+};
+
 /** Destructor for mmapped cache entries.
  * @param ce  Cache entry.
  */
@@ -46,37 +153,115 @@ static void
 unmap_entry(void *data, struct cache_entry *ce)
 {
 	struct fcache *fc = data;
-	if (ce->data != MAP_FAILED)
-		munmap(ce->data, fc->mmapsz);
+	if (ce->data != MAP_FAILED) {
+		size_t size = region_size(fc, ce->key);
+		munmap(ce->data, size);
+		fc->mapped -= size;
+		++fc->nunmaps;
+	}
+}
+
+/** Limit the number of cache elements by a memory budget.
+ * @param n       Requested number of elements.
+ * @param size    Size of one element in bytes.
+ * @param budget  Memory budget in bytes, or zero if unlimited.
+ * @returns       Number of elements which fit into @p budget,
+ *                but at most @p n.
+ */
+static unsigned
+budget_count(unsigned n, size_t size, kdump_num_t budget)
+{
+	return budget && budget / size < n
+		? budget / size
+		: n;
 }
 
 /** Allocate and initialize a new file cache.
- * @param fd     File descriptor.
- * @param n      Number of elements in the cache.
- * @param order  Page order of mmap regions.
- * @returns      File cache object, or @c NULL on allocation failure.
+ * @param fd      File descriptor.
+ * @param n       Number of elements in the cache.
+ * @param order   Page order of mmap regions.
+ * @param adaptive  Enlarge mmap regions for sequential reads.
+ * @param budget  Maximum memory used by the cache in bytes,
+ *                or zero if unlimited.
+ * @returns       File cache object, or @c NULL on allocation failure.
+ *
+ * The budget is split evenly between mmap regions and the fallback
+ * cache. It bounds the maximum size of both caches, including growth
+ * (see @ref fcache_scale). If not even one mmap region fits into the
+ * budget, the file is read only with pread(), but the fallback cache
+ * always has at least one element.
+ *
+ * If @p adaptive is @c true, the page order of mmap regions grows
+ * while the file is read sequentially, up to @ref FCACHE_ADAPT_MAX_SIZE
+ * bytes per region, or less if the maximum number of regions would not
+ * fit into the budget.
  */
 struct fcache *
-fcache_new(int fd, unsigned n, unsigned order)
+fcache_new(int fd, unsigned n, unsigned order, bool adaptive,
+	   kdump_num_t budget)
 {
 	struct fcache *fc;
 	struct stat st;
+	unsigned max;
 
 	fc = malloc(sizeof *fc);
 	if (!fc)
 		return fc;
 
+	if (mutex_init(&fc->mutex, NULL))
+		goto err;
+
 	fc->refcnt = 1;
 	fc->fd = fd;
 	fc->pgsz = sysconf(_SC_PAGESIZE);
 	fc->mmapsz = fc->pgsz << order;
+	fc->order = order;
+	fc->base_order = order;
+	fc->max_order = order;
+	fc->seqmiss = 0;
+	fc->randmiss = 0;
+	fc->seqidx = 0;
+	memset(fc->seqend, 0, sizeof fc->seqend);
+	fc->mapped = 0;
+	fc->nmaps = 0;
+	fc->nunmaps = 0;
+	fc->bytes_mapped.number = 0;
+	fc->maps.number = 0;
+	fc->unmaps.number = 0;
+	fc->map = NULL;
+	fc->ring = NULL;
+	fc->advice = fa_normal;
+	fc->auto_advice = true;
+	fc->pattern = 0;
+	fc->advice_name.string = advice_names[fa_normal];
+	fc->pool = NULL;
+	fc->npool = 0;
+	fc->poolsz = 0;
+	fc->nallocs = 0;
+	fc->chunk_allocs.number = 0;
 
-	fc->cache = cache_alloc(1 << order, 0);
-	if (!fc->cache)
-		goto err;
-	set_cache_entry_cleanup(fc->cache, unmap_entry, fc);
+	max = budget_count(FCACHE_MAX_SCALE * n, fc->mmapsz, budget / 2);
+	if (max) {
+		fc->cache = cache_alloc(n < max ? n : max, max, 0, false);
+		if (!fc->cache)
+			goto err_mutex;
+		set_cache_entry_cleanup(fc->cache, unmap_entry, fc);
+
+		if (adaptive)
+			while ((fc->pgsz << (fc->max_order + 1)) <=
+			       FCACHE_ADAPT_MAX_SIZE &&
+			       (!budget ||
+				(kdump_num_t)max * (fc->pgsz << (fc->max_order + 1))
+				<= budget / 2))
+				++fc->max_order;
+	} else
+		fc->cache = NULL;
 
-	fc->fbcache = cache_alloc(1 << order, fc->pgsz);
+	max = budget_count(FCACHE_MAX_SCALE << order, fc->pgsz, budget / 2);
+	if (!max)
+		max = 1;
+	fc->fbcache = cache_alloc(1U << order < max ? 1U << order : max,
+				  max, fc->pgsz, false);
 	if (!fc->fbcache)
 		goto err_cache;
 
@@ -87,46 +272,421 @@ fcache_new(int fd, unsigned n, unsigned order)
 	return fc;
 
  err_cache:
-	cache_free(fc->cache);
+	if (fc->cache)
+		cache_free(fc->cache);
+ err_mutex:
+	mutex_destroy(&fc->mutex);
  err:
 	free(fc);
 	return NULL;
 }
 
+/** Map the whole file.
+ * @param fc  File cache object (not shared yet).
+ * @returns   @c true on success, @c false if the file cannot be mapped.
+ *
+ * On success, all data up to the end of the file is accessed through
+ * this mapping without any lookup, locking or reference counting, so
+ * the cache of mmap regions stays empty. Data beyond the end of file is
+ * still read into the fallback cache. On failure, the file cache is left
+ * unchanged, i.e. the file is mapped in regions.
+ */
+bool
+fcache_map_file(struct fcache *fc)
+{
+	struct stat st;
+	void *map;
+
+	if (fstat(fc->fd, &st) || !S_ISREG(st.st_mode) || !st.st_size ||
+	    (unsigned long long)st.st_size > SIZE_MAX)
+		return false;
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fc->fd, 0);
+	if (map == MAP_FAILED)
+		return false;
+
+	fc->map = map;
+	fc->filesz = st.st_size;
+	return true;
+}
+
+/** Read the file with io_uring.
+ * @param fc  File cache object (not shared yet).
+ * @returns   @c true on success, @c false if io_uring is not available.
+ *
+ * On success, the file is no longer mapped in regions. All data is read
+ * into the fallback cache, and pages of a read which spans multiple
+ * pages are requested from the kernel at once. On failure, the file
+ * cache is left unchanged.
+ */
+bool
+fcache_use_uring(struct fcache *fc)
+{
+	if (mutex_init(&fc->ring_mutex, NULL))
+		return false;
+	fc->ring = uring_new(FCACHE_URING_DEPTH);
+	if (!fc->ring) {
+		mutex_destroy(&fc->ring_mutex);
+		return false;
+	}
+
+	if (fc->cache) {
+		cache_free(fc->cache);
+		fc->cache = NULL;
+	}
+	return true;
+}
+
 /** Free a file cache.
  * @param fc  File cache object.
  */
 void
 fcache_free(struct fcache *fc)
 {
+	struct fcache_buf *buf;
+
+	while ((buf = fc->pool)) {
+		fc->pool = buf->next;
+		free(buf);
+	}
+	if (fc->ring) {
+		uring_free(fc->ring);
+		mutex_destroy(&fc->ring_mutex);
+	}
 	cache_free(fc->fbcache);
-	cache_free(fc->cache);
+	if (fc->cache)
+		cache_free(fc->cache);
+	if (fc->map)
+		munmap(fc->map, fc->filesz);
+	mutex_destroy(&fc->mutex);
 	free(fc);
 }
 
-/** Get file cache content.
+/** Update file cache statistics.
+ * @param fc  File cache object.
+ */
+void
+fcache_update_stats(struct fcache *fc)
+{
+	mutex_lock(&fc->mutex);
+	fc->bytes_mapped.number = fc->mapped;
+	if (fc->map)
+		fc->bytes_mapped.number += fc->filesz;
+	fc->maps.number = fc->nmaps;
+	fc->unmaps.number = fc->nunmaps;
+	fc->advice_name.string = advice_names[fc->advice];
+	fc->chunk_allocs.number = fc->nallocs;
+	mutex_unlock(&fc->mutex);
+
+	if (fc->cache)
+		cache_update_stats(fc->cache);
+	cache_update_stats(fc->fbcache);
+}
+
+/** Scale a file cache.
+ * @param fc      File cache object.
+ * @param factor  Scaling factor.
+ *
+ * Grow both the mmap cache and the fallback cache to @p factor times
+ * their initial size, but at most @ref FCACHE_MAX_SCALE times.
+ */
+void
+fcache_scale(struct fcache *fc, unsigned factor)
+{
+	if (fc->cache)
+		cache_scale(fc->cache, factor);
+	cache_scale(fc->fbcache, factor);
+}
+
+/** Adapt the size of mmap regions to the access pattern.
+ * @param fc   File cache object (locked).
+ * @param pos  File position of a region miss.
+ * @returns    @c true if the page order has changed.
+ *
+ * A miss is sequential if the region which contains @p pos starts at
+ * (or includes) the end of a recently mapped region. Tracking several
+ * regions allows to detect a sequential stream even if it is interleaved
+ * with reads from other parts of the file, e.g. page descriptors.
+ */
+static bool
+adapt_order(struct fcache *fc, off_t pos)
+{
+	off_t blkpos = pos & ~(off_t)(fc->mmapsz - 1);
+	unsigned order = fc->order;
+	bool changed;
+	unsigned i;
+
+	for (i = 0; i < FCACHE_STREAMS; ++i)
+		if (fc->seqend[i] >= blkpos &&
+		    fc->seqend[i] - blkpos < fc->mmapsz)
+			break;
+
+	if (i < FCACHE_STREAMS) {
+		fc->randmiss = 0;
+		if (++fc->seqmiss >= FCACHE_ADAPT_MISSES &&
+		    order < fc->max_order)
+			++order;
+	} else {
+		fc->seqmiss = 0;
+		if (++fc->randmiss >= FCACHE_ADAPT_MISSES &&
+		    order > fc->base_order)
+			--order;
+	}
+
+	changed = (order != fc->order);
+	if (changed) {
+		fc->order = order;
+		fc->mmapsz = fc->pgsz << order;
+		fc->seqmiss = 0;
+		fc->randmiss = 0;
+		blkpos = pos & ~(off_t)(fc->mmapsz - 1);
+	}
+
+	fc->seqend[fc->seqidx] = blkpos + fc->mmapsz;
+	fc->seqidx = (fc->seqidx + 1) % FCACHE_STREAMS;
+	return changed;
+}
+
+/** Parse the name of an access pattern advice.
+ * @param name    Advice name.
+ * @param advice  Parsed advice, set on success.
+ * @returns       @c true on success, @c false if @p name is unknown.
+ */
+bool
+fcache_advice_parse(const char *name, enum fcache_advice *advice)
+{
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(advice_names); ++i)
+		if (!strcmp(name, advice_names[i])) {
+			*advice = i;
+			return true;
+		}
+	return false;
+}
+
+/** Give access pattern advice to the kernel.
+ * @param fc      File cache object.
+ * @param advice  New advice.
+ *
+ * The advice applies to the whole file and to the mapping of the whole
+ * file (if any). Regions which are already mapped keep their previous
+ * advice until they are evicted; new regions get the new advice when
+ * they are mapped. This function does not change @c fc->advice.
+ */
+static void
+apply_advice(struct fcache *fc, enum fcache_advice advice)
+{
+	posix_fadvise(fc->fd, 0, 0, fadv_values[advice]);
+	if (fc->map)
+		madvise(fc->map, fc->filesz, madv_values[advice]);
+}
+
+/** Set fixed access pattern advice.
+ * @param fc      File cache object (not shared yet).
+ * @param advice  Advice.
+ *
+ * The advice is given to the kernel immediately, and it is no longer
+ * changed according to the detected access pattern.
+ */
+void
+fcache_advise(struct fcache *fc, enum fcache_advice advice)
+{
+	fc->auto_advice = false;
+	fc->advice = advice;
+	apply_advice(fc, advice);
+}
+
+/** Report the access pattern of a reader.
  * @param fc   File cache object.
+ * @param seq  @c true if the reader reads sequentially.
+ *
+ * Page cache readers call this function when they read ahead (which
+ * means they read sequentially) or when they miss a page which does
+ * not follow their previous read. The advice given to the kernel is
+ * changed when there are enough reports of one kind, so that a few
+ * reports of the other kind do not switch it back and forth.
+ *
+ * This function is called on hot paths, so it does not take any lock.
+ * The score is updated atomically, and only the thread which changes
+ * @c fc->advice passes the new advice to the kernel.
+ */
+void
+fcache_note_access(struct fcache *fc, bool seq)
+{
+	enum fcache_advice cur, advice;
+	int pattern, next;
+
+	if (!fc->auto_advice)
+		return;
+
+	do {
+		pattern = fc->pattern;
+		next = seq ? pattern + 1 : pattern - 1;
+		if (next > FCACHE_ADVICE_MISSES ||
+		    next < -FCACHE_ADVICE_MISSES)
+			return;
+	} while (!__sync_bool_compare_and_swap(&fc->pattern, pattern, next));
+
+	cur = fc->advice;
+	advice = cur;
+	if (next == FCACHE_ADVICE_MISSES)
+		advice = fa_sequential;
+	else if (next == -FCACHE_ADVICE_MISSES)
+		advice = fa_random;
+	else if ((cur == fa_sequential && next <= 0) ||
+		 (cur == fa_random && next >= 0))
+		advice = fa_normal;
+	if (advice != cur &&
+	    __sync_bool_compare_and_swap(&fc->advice, cur, advice))
+		apply_advice(fc, advice);
+}
+
+/** Start reading file data in the background.
+ * @param fc   File cache object.
+ * @param pos  File position.
+ * @param len  Length of data.
+ *
+ * This is only a hint to the kernel to read the data into the page
+ * cache. With io_uring, the request is queued without waiting for it.
+ * If the whole file is mapped, the mapped range is advised with
+ * madvise(). Otherwise, the kernel is advised with posix_fadvise().
+ */
+void
+fcache_readahead(struct fcache *fc, off_t pos, off_t len)
+{
+	if (fc->ring) {
+		mutex_lock(&fc->ring_mutex);
+		uring_advise(fc->ring, fc->fd, pos, len);
+		mutex_unlock(&fc->ring_mutex);
+	} else if (fc->map && pos < fc->filesz) {
+		off_t start = pos & ~(off_t)(fc->pgsz - 1);
+		if (len > fc->filesz - pos)
+			len = fc->filesz - pos;
+		madvise(fc->map + start, pos + len - start, MADV_WILLNEED);
+	} else
+		posix_fadvise(fc->fd, pos, len, POSIX_FADV_WILLNEED);
+}
+
+/** Load fallback cache pages with one io_uring submission.
+ * @param fc   File cache object.
+ * @param pos  File position.
+ * @param len  Length of data.
+ *
+ * Pages which are not cached yet are read with io_uring, up to
+ * @ref FCACHE_URING_DEPTH pages at a time. Loading stops if the
+ * fallback cache is full. Errors are ignored here; the caller then
+ * reads the missing pages with pread() and reports any errors.
+ *
+ * The file cache lock is held only while the cache entries are taken
+ * and while they are inserted (or discarded), so other threads can
+ * look up cached data while the I/O is in progress.
+ */
+static void
+load_pages(struct fcache *fc, off_t pos, size_t len)
+{
+	struct cache_entry *ce[FCACHE_URING_DEPTH];
+	struct uring_read rd[FCACHE_URING_DEPTH];
+	off_t blkpos, end;
+	unsigned i, n;
+	bool full;
+
+	blkpos = pos & ~(fc->pgsz - 1);
+	end = pos + len;
+	full = false;
+
+	while (blkpos < end && !full) {
+		n = 0;
+		mutex_lock(&fc->mutex);
+		while (blkpos < end && n < FCACHE_URING_DEPTH) {
+			ce[n] = cache_get_entry(fc->fbcache, blkpos);
+			if (!ce[n]) {
+				full = true;
+				break;
+			}
+			if (cache_entry_valid(ce[n])) {
+				cache_put_entry(fc->fbcache, ce[n]);
+			} else {
+				rd[n].buf = ce[n]->data;
+				rd[n].len = fc->pgsz;
+				rd[n].pos = blkpos;
+				++n;
+			}
+			blkpos += fc->pgsz;
+		}
+		mutex_unlock(&fc->mutex);
+		if (!n)
+			continue;
+
+		mutex_lock(&fc->ring_mutex);
+		if (uring_read(fc->ring, fc->fd, rd, n))
+			for (i = 0; i < n; ++i)
+				rd[i].res = -1;
+		mutex_unlock(&fc->ring_mutex);
+
+		mutex_lock(&fc->mutex);
+		for (i = 0; i < n; ++i) {
+			if (rd[i].res < 0) {
+				cache_discard(fc->fbcache, ce[i]);
+				continue;
+			}
+			if ((size_t)rd[i].res < fc->pgsz)
+				memset(ce[i]->data + rd[i].res, 0,
+				       fc->pgsz - rd[i].res);
+			cache_insert(fc->fbcache, ce[i]);
+			cache_put_entry(fc->fbcache, ce[i]);
+		}
+		mutex_unlock(&fc->mutex);
+	}
+}
+
+/** Get file cache content with the file cache locked.
+ * @param fc   File cache object (locked).
  * @param fce  File cache entry, updated on success.
  * @param pos  File position.
  * @returns    Error status.
  */
-kdump_status
-fcache_get(struct fcache *fc, struct fcache_entry *fce, off_t pos)
+static kdump_status
+fcache_get_locked(struct fcache *fc, struct fcache_entry *fce, off_t pos)
 {
 	off_t blkpos;
 	size_t off;
 	struct cache_entry *ce;
 
 	blkpos = pos & ~(fc->pgsz - 1);
-	if (blkpos < fc->filesz) {
+	if (fc->cache && blkpos < fc->filesz) {
+		bool adapted = false;
+
+	again:
 		blkpos = pos & ~(fc->mmapsz - 1);
-		ce = cache_get_entry(fc->cache, blkpos);
+		ce = cache_get_entry(fc->cache,
+				     region_key(fc, blkpos, fc->order));
 		if (!ce)
 			return KDUMP_ERR_BUSY;
 
 		if (!cache_entry_valid(ce)) {
+			if (fc->max_order > fc->base_order && !adapted) {
+				adapted = true;
+				if (adapt_order(fc, pos)) {
+					cache_discard(fc->cache, ce);
+					goto again;
+				}
+			}
+
 			ce->data = mmap(NULL, fc->mmapsz, PROT_READ,
 					MAP_SHARED, fc->fd, blkpos);
+			if (ce->data != MAP_FAILED) {
+				fc->mapped += fc->mmapsz;
+				++fc->nmaps;
+				if (fc->advice != fa_normal)
+					madvise(ce->data, fc->mmapsz,
+						madv_values[fc->advice]);
+				if (fc->advice == fa_sequential)
+					posix_fadvise(fc->fd,
+						      blkpos + fc->mmapsz,
+						      fc->mmapsz,
+						      POSIX_FADV_WILLNEED);
+			}
 			cache_insert(fc->cache, ce);
 		}
 
@@ -164,6 +724,38 @@ fcache_get(struct fcache *fc, struct fcache_entry *fce, off_t pos)
 	return KDUMP_OK;
 }
 
+/** Get file cache content.
+ * @param fc   File cache object.
+ * @param fce  File cache entry, updated on success.
+ * @param pos  File position.
+ * @returns    Error status.
+ *
+ * The file cache lock is held only while looking up (and possibly
+ * filling) the cache entry. The data can be accessed without any
+ * lock, because the entry is referenced until @ref fcache_put.
+ *
+ * If the whole file is mapped, no lock is needed at all, and the
+ * returned entry extends up to the end of the file.
+ */
+kdump_status
+fcache_get(struct fcache *fc, struct fcache_entry *fce, off_t pos)
+{
+	kdump_status ret;
+
+	if (fc->map && pos < fc->filesz) {
+		fce->data = fc->map + pos;
+		fce->len = fc->filesz - pos;
+		fce->ce = NULL;
+		fce->cache = NULL;
+		return KDUMP_OK;
+	}
+
+	mutex_lock(&fc->mutex);
+	ret = fcache_get_locked(fc, fce, pos);
+	mutex_unlock(&fc->mutex);
+	return ret;
+}
+
 /** Get file cache content with a fallback buffer.
  * @param fc   File cache object.
  * @param fce  File cache entry, updated on success.
@@ -210,6 +802,9 @@ fcache_pread(struct fcache *fc, void *buf, size_t len, off_t pos)
 	struct fcache_entry fce;
 	kdump_status ret;
 
+	if (fc->ring && (pos & (fc->pgsz - 1)) + len > fc->pgsz)
+		load_pages(fc, pos, len);
+
 	while (len) {
 		size_t partlen;
 
@@ -240,17 +835,79 @@ put_fces(struct fcache_entry *fces, size_t n)
 		fcache_put(&fces[n]);
 }
 
-/** Free an array of file cache entries.
- * @param fces  Array of file cache entries.
- * @param n     Number of entries in the array.
+/** Get a chunk buffer.
+ * @param fc    File cache object.
+ * @param size  Minimum size of the buffer in bytes.
+ * @returns     Buffer data, or @c NULL on allocation failure.
+ *
+ * The smallest free buffer which is big enough is taken from the pool.
+ * If there is none, a new buffer is allocated. Its size is rounded up
+ * to a power of two (at least one page), so that it can be reused for
+ * requests of a similar size.
+ */
+static void *
+pool_get(struct fcache *fc, size_t size)
+{
+	struct fcache_buf *buf, **pprev, **pbest;
+	size_t bufsz;
+
+	mutex_lock(&fc->mutex);
+	pbest = NULL;
+	for (pprev = &fc->pool; (buf = *pprev); pprev = &buf->next)
+		if (buf->size >= size &&
+		    (!pbest || buf->size < (*pbest)->size))
+			pbest = pprev;
+	if (pbest) {
+		buf = *pbest;
+		*pbest = buf->next;
+		--fc->npool;
+		fc->poolsz -= buf->size;
+		mutex_unlock(&fc->mutex);
+		return buf + 1;
+	}
+	++fc->nallocs;
+	mutex_unlock(&fc->mutex);
+
+	for (bufsz = fc->pgsz; bufsz < size; bufsz <<= 1)
+		if (bufsz > SIZE_MAX / 2) {
+			bufsz = size;
+			break;
+		}
+	if (bufsz > SIZE_MAX - sizeof *buf)
+		return NULL;
+	buf = malloc(sizeof *buf + bufsz);
+	if (!buf)
+		return NULL;
+	buf->size = bufsz;
+	return buf + 1;
+}
+
+/** Return a chunk buffer to the pool.
+ * @param fc    File cache object.
+ * @param data  Buffer data returned by @ref pool_get, or @c NULL.
+ *
+ * If the pool is full, the buffer is freed.
  */
 static void
-free_fces(struct fcache_entry *fces, size_t n)
+pool_put(struct fcache *fc, void *data)
 {
-	if (fces) {
-		put_fces(fces, n);
-		free(fces);
+	struct fcache_buf *buf;
+
+	if (!data)
+		return;
+
+	buf = (struct fcache_buf *)data - 1;
+	mutex_lock(&fc->mutex);
+	if (fc->npool < FCACHE_POOL_BUFS &&
+	    buf->size <= FCACHE_POOL_BYTES - fc->poolsz) {
+		buf->next = fc->pool;
+		fc->pool = buf;
+		++fc->npool;
+		fc->poolsz += buf->size;
+		buf = NULL;
 	}
+	mutex_unlock(&fc->mutex);
+	free(buf);
 }
 
 /** Copy data out of an array of file cache entries.
@@ -276,6 +933,11 @@ copy_data(void *data, struct fcache_entry *fces, size_t n)
  * @param len  Length of data.
  * @param pos  File position.
  * @returns    Error status.
+ *
+ * Arrays of cache entries (for chunks which span more than
+ * @ref MAX_EMBED_FCES blocks) and buffers for data which is not
+ * contiguous in memory are taken from a pool of the file cache, so
+ * that repeated reads of similar chunks do not allocate any memory.
  */
 kdump_status
 fcache_get_chunk(struct fcache *fc, struct fcache_chunk *fch,
@@ -289,17 +951,30 @@ fcache_get_chunk(struct fcache *fc, struct fcache_chunk *fch,
 	size_t nent;
 	kdump_status status;
 
+	fch->fc = fc;
 	if (!len) {
 		fch->data = NULL;
 		fch->nent = 0;
 		return KDUMP_OK;
 	}
 
+	if (fc->map && pos + len <= fc->filesz) {
+		fch->data = fc->map + pos;
+		fch->nent = 1;
+		fch->embed_fces->data = fch->data;
+		fch->embed_fces->len = len;
+		fch->embed_fces->ce = NULL;
+		fch->embed_fces->cache = NULL;
+		return KDUMP_OK;
+	}
+
 	first = pos & ~(fc->pgsz - 1);
 	last = (pos + len - 1) & ~(fc->pgsz - 1);
 	nent = (last - first) / fc->pgsz + 1;
+	if (fc->ring && nent > 1)
+		load_pages(fc, pos, len);
 	if (nent > MAX_EMBED_FCES) {
-		fces = malloc(nent * sizeof(*fces));
+		fces = pool_get(fc, nent * sizeof(*fces));
 		if (!fces)
 			return KDUMP_ERR_SYSTEM;
 		curfce = fces;
@@ -314,9 +989,11 @@ fcache_get_chunk(struct fcache *fc, struct fcache_chunk *fch,
 	while (remain) {
 		status = fcache_get(fc, curfce, pos);
 		if (status != KDUMP_OK) {
-			put_fces(curfce - nent, nent);
-			if (fces)
-				free(fces);
+			if (data)
+				pool_put(fc, data);
+			else
+				put_fces(curfce - nent, nent);
+			pool_put(fc, fces);
 			return status;
 		}
 
@@ -327,19 +1004,18 @@ fcache_get_chunk(struct fcache *fc, struct fcache_chunk *fch,
 			curdata = curfce->data;
 		else if (curfce->data != curdata) {
 			if (!data) {
-				data = malloc(len);
+				data = pool_get(fc, len);
 				if (!data) {
 					put_fces(curfce - nent, nent + 1);
-					if (fces)
-						free(fces);
+					pool_put(fc, fces);
 					return KDUMP_ERR_SYSTEM;
 				}
 				curdata = copy_data(data, curfce - nent, nent);
 				put_fces(curfce - nent, nent);
 				fce = *curfce;
 				curfce = &fce;
-				if (fces)
-					free(fces);
+				pool_put(fc, fces);
+				fces = NULL;
 			}
 			memcpy(curdata, curfce->data, curfce->len);
 		}
@@ -365,7 +1041,7 @@ fcache_get_chunk(struct fcache *fc, struct fcache_chunk *fch,
 	} else {
 		if (fces) {
 			memcpy(fch->embed_fces, fces, nent * sizeof(*fces));
-			free(fces);
+			pool_put(fc, fces);
 		}
 		fch->data = fch->embed_fces->data;
 	}
@@ -379,10 +1055,13 @@ fcache_get_chunk(struct fcache *fc, struct fcache_chunk *fch,
 void
 fcache_put_chunk(struct fcache_chunk *fch)
 {
-	if (fch->nent > MAX_EMBED_FCES)
-		free_fces(fch->fces, fch->nent);
-	else if (fch->nent)
+	if (fch->nent > MAX_EMBED_FCES) {
+		put_fces(fch->fces, fch->nent);
+		pool_put(fch->fc, fch->fces);
+	} else if (fch->nent)
 		put_fces(fch->embed_fces, fch->nent);
+	else if (fch->fc)
+		pool_put(fch->fc, fch->data);
 	else
 		free(fch->data);
 }
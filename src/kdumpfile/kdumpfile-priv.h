@@ -165,6 +165,12 @@ struct format_ops {
 	 */
 	kdump_status (*probe)(kdump_ctx_t *ctx);
 
+	/** Page data may change while the dump is open.
+	 * This is set for live memory. Copies of such data must not be
+	 * kept between reads.
+	 */
+	bool live;
+
 	/** Get page data.
 	 * @param ctx  Dump file object.
 	 * @param pio  Page I/O control.
@@ -182,6 +188,28 @@ struct format_ops {
 	 */
 	void (*put_page)(kdump_ctx_t *ctx, struct page_io *pio);
 
+	/** Read page data into a cache entry (optional).
+	 * @param ctx  Dump file object.
+	 * @param pio  Page I/O control.
+	 *
+	 * Formats which get all pages with @ref cache_get_page set this
+	 * to the read function which they pass to it. Reads which span
+	 * multiple pages can then get the pages in batches.
+	 */
+	kdump_status (*read_page)(kdump_ctx_t *ctx, struct page_io *pio);
+
+	/** Start reading file data of pages in the background (optional).
+	 * @param ctx   Dump file object.
+	 * @param addr  Full address of the first page.
+	 * @param n     Number of pages.
+	 *
+	 * This method is called before pages are read ahead or prefetched.
+	 * It passes the corresponding file ranges to @ref fcache_readahead,
+	 * so that the kernel can read them while the pages are loaded.
+	 */
+	void (*read_ahead)(kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr,
+			   unsigned n);
+
 	/** Address translation post-hook.
 	 * @param ctx  Dump file object.
 	 * @returns    Status code.
@@ -549,8 +577,30 @@ struct kdump_shared {
 	int arch_init_done;	/**< Non-zero if arch init has been called. */
 
 	struct cache *cache;	/**< Page cache. */
+
+	/** Page cache partitions, one for each NUMA node, or @c NULL if
+	 * the page cache is not partitioned. The first partition is also
+	 * stored in @c cache. */
+	struct cache **node_cache;
+
+	/** NUMA topology (if @c node_cache is not @c NULL). */
+	struct numa_topology *numa;
+
 	struct fcache *fcache;	/**< File cache. */
-	mutex_t cache_lock;	/**< Cache access lock. */
+	struct prefetch_pool *prefetch; /**< Prefetch worker pool. */
+	struct pcache *pcache;	/**< Persistent page cache. */
+
+	/** Size of pages pinned by all dump file objects. */
+	kdump_attr_value_t pinned_bytes;
+
+	/** Private cache hits of dump file objects which were freed. */
+	unsigned long l1_hits;
+
+	/** Private cache misses of dump file objects which were freed. */
+	unsigned long l1_misses;
+
+	/** Remote partition hits of dump file objects which were freed. */
+	unsigned long remote_hits;
 
 	/** Static attributes. */
 #define ATTR(dir, key, field, type, ctype, ...)	\
@@ -652,21 +702,77 @@ xlat_decref(struct kdump_xlat *xlat)
 	return 0;
 }
 
-/** Number of read cache slots. */
-#define READ_CACHE_SLOTS	4
+/** Default number of read cache pages. */
+#define DEFAULT_READ_CACHE_PAGES	8
 
-/** Size of each read cache slot. */
-#define READ_CACHE_SIZE		128
+/** Maximum number of read cache pages. */
+#define MAX_READ_CACHE_PAGES		64
 
-/** Read cache storage and metadata. */
+/** Read cache storage and metadata.
+ * The read cache holds copies of page table pages. It is a two-way
+ * set-associative cache: a page can be stored only in one of the two
+ * slots of the set selected by a hash of its address, and the more
+ * recently used page of a set is in the first slot.
+ */
 struct cached_reads {
-	unsigned slot;		/**< Slot of the last cached read. */
+	unsigned nsets;		/**< Number of two-slot sets. */
+	unsigned shift;		/**< Page shift. */
+	unsigned long hits;	/**< Number of cache hits. */
+	unsigned long misses;	/**< Number of cache misses. */
+
+	/** Cache keys (combined address and address space). */
+	addrxlat_addr_t *key;
+
+	/** Page data of each slot (pointers into @c data). */
+	unsigned char **page;
+
+	/** Storage for page data. */
+	unsigned char *data;
+};
+
+/** Default number of pages in the private page cache. */
+#define DEFAULT_L1_PAGES	32
+
+/** Maximum number of pages in the private page cache. */
+#define MAX_L1_PAGES		256
+
+/** Private page cache.
+ * Copies of recently read pages, which are searched before the shared
+ * cache without taking any locks. The cache is direct-mapped: a page
+ * can be stored only in the slot selected by a hash of its address.
+ */
+struct l1_cache {
+	unsigned n;		/**< Number of slots. */
+	unsigned shift;		/**< Page shift. */
+	size_t size;		/**< Size of each slot (page size). */
+	unsigned long hits;	/**< Number of cache hits. */
+	unsigned long misses;	/**< Number of cache misses. */
 
 	/** Cache keys (combined address and address space). */
-	addrxlat_addr_t key[READ_CACHE_SLOTS];
+	kdump_addr_t *key;
+
+	/** Keys of pages which were last missed in each slot. */
+	kdump_addr_t *ghost;
 
-	/** Cached values. */
-	unsigned char val[READ_CACHE_SLOTS][READ_CACHE_SIZE];
+	/** Page data (@c n slots of @c size bytes). */
+	unsigned char *data;
+};
+
+/** Sequential read detector. */
+struct readahead {
+	kdump_addr_t next;	/**< Key of the next page in sequence. */
+	kdump_addr_t ahead;	/**< First page not yet read ahead. */
+	unsigned run;		/**< Number of sequential pages so far. */
+	bool disabled;		/**< Do not read ahead for this context. */
+};
+
+/** Pages pinned by a dump file object.
+ * @sa kdump_pin_range
+ */
+struct pinned_pages {
+	struct pinned_page *page; /**< Pinned pages (array). */
+	size_t n;		  /**< Number of pinned pages. */
+	size_t alloc;		  /**< Number of allocated elements. */
 };
 
 /**  Representation of a dump file.
@@ -694,6 +800,29 @@ struct _kdump_ctx {
 	/** Cached reads. */
 	struct cached_reads cached;
 
+	/** Private page cache. */
+	struct l1_cache l1;
+
+	/** Sequential read detector. */
+	struct readahead ra;
+
+	/** Pinned pages. */
+	struct pinned_pages pinned;
+
+	/** Read flags (see @ref kdump_set_read_flags). */
+	unsigned long read_flags;
+
+	/** Set while pages are loaded only as a hint (prefetch).
+	 * Page cache lookups then never wait, even in wait mode. */
+	bool nowait;
+
+	/** Page cache partition used by this object, or -1 to use the
+	 * partition of the current NUMA node. */
+	int numa_node;
+
+	/** Number of pages found in another node's cache partition. */
+	unsigned long remote_hits;
+
 	/** Per-context data. */
 	void *data[PER_CTX_SLOTS];
 
@@ -705,6 +834,9 @@ struct _kdump_ctx {
 /* Per-context data */
 
 INTERNAL_DECL(int, per_ctx_alloc, (struct kdump_shared *shared, size_t sz));
+INTERNAL_DECL(kdump_ctx_t *, alloc_private_ctx,
+	      (struct kdump_shared *shared));
+INTERNAL_DECL(void, free_private_ctx, (kdump_ctx_t *ctx));
 INTERNAL_DECL(void, per_ctx_free, (struct kdump_shared *shared, int slot));
 
 /* File formats */
@@ -766,6 +898,53 @@ INTERNAL_DECL(addrxlat_status, kdump2addrxlat,
 INTERNAL_DECL(void *, ctx_malloc,
 	      (size_t size, kdump_ctx_t *ctx, const char *desc));
 
+/* NUMA topology */
+
+/**  NUMA topology of the running system.
+ */
+struct numa_topology {
+	unsigned nnodes;	/**< Number of online nodes. */
+	unsigned *node_id;	/**< System node number of each node. */
+	unsigned ncpus;		/**< Number of elements in @c cpu_node. */
+	unsigned cpu_node[];	/**< Node index of each CPU. */
+};
+
+INTERNAL_DECL(struct numa_topology *, numa_topology_read, (void));
+INTERNAL_DECL(void, numa_topology_free, (struct numa_topology *numa));
+INTERNAL_DECL(unsigned, numa_local_node,
+	      (const struct numa_topology *numa));
+INTERNAL_DECL(bool, numa_bind,
+	      (const struct numa_topology *numa, unsigned node,
+	       void *ptr, size_t len));
+
+/**  Backing memory of a data area.
+ */
+enum data_mode {
+	dm_malloc,		/**< Allocated with malloc(). */
+	dm_mmap,		/**< Anonymous mapping with normal pages. */
+	dm_thp,			/**< Anonymous mapping with transparent
+				 *   huge pages. */
+	dm_hugetlb,		/**< Mapping from the huge page pool. */
+};
+
+/**  Large data area, possibly backed by huge pages.
+ */
+struct data_area {
+	void *ptr;		/**< Start of the data area. */
+	size_t size;		/**< Size of the mapping (or allocation). */
+	enum data_mode mode;	/**< Backing memory type. */
+};
+
+INTERNAL_DECL(bool, huge_area_alloc,
+	      (struct data_area *area, size_t size));
+INTERNAL_DECL(bool, data_area_alloc,
+	      (struct data_area *area, size_t size, bool huge));
+INTERNAL_DECL(bool, node_area_alloc,
+	      (struct data_area *area, size_t size, bool huge,
+	       const struct numa_topology *numa, unsigned node));
+INTERNAL_DECL(void, data_area_free, (struct data_area *area));
+INTERNAL_DECL(const char *, data_mode_name, (enum data_mode mode));
+
 INTERNAL_DECL(kdump_status, set_uts,
 	      (kdump_ctx_t *ctx, const struct new_utsname *src));
 INTERNAL_DECL(int, uts_looks_sane, (struct new_utsname *uts));
@@ -1106,6 +1285,21 @@ INTERNAL_DECL(extern const struct attr_ops, file_fd_ops, );
 INTERNAL_DECL(extern const struct attr_ops, page_size_ops, );
 INTERNAL_DECL(extern const struct attr_ops, page_shift_ops, );
 INTERNAL_DECL(extern const struct attr_ops, cache_size_ops, );
+INTERNAL_DECL(extern const struct attr_ops, cache_limit_ops, );
+INTERNAL_DECL(extern const struct attr_ops, cache_wait_ops, );
+INTERNAL_DECL(extern const struct attr_ops, cache_policy_ops, );
+INTERNAL_DECL(extern const struct attr_ops, cache_readahead_ops, );
+INTERNAL_DECL(extern const struct attr_ops, l1_pages_ops, );
+INTERNAL_DECL(extern const struct attr_ops, l1_cache_stats_ops, );
+INTERNAL_DECL(extern const struct attr_ops, numa_stats_ops, );
+INTERNAL_DECL(extern const struct attr_ops, prefetch_threads_ops, );
+INTERNAL_DECL(extern const struct attr_ops, pcache_path_ops, );
+INTERNAL_DECL(extern const struct attr_ops, pcache_pages_ops, );
+INTERNAL_DECL(extern const struct attr_ops, pcache_stats_ops, );
+INTERNAL_DECL(extern const struct attr_ops, cache_stats_ops, );
+INTERNAL_DECL(extern const struct attr_ops, fcache_stats_ops, );
+INTERNAL_DECL(extern const struct attr_ops, xlat_cache_stats_ops, );
+INTERNAL_DECL(extern const struct attr_ops, xlat_cache_pages_ops, );
 INTERNAL_DECL(extern const struct attr_ops, arch_name_ops, );
 INTERNAL_DECL(extern const struct attr_ops, ostype_ops, );
 INTERNAL_DECL(extern const struct attr_ops, uts_machine_ops, );
@@ -1162,6 +1356,9 @@ typedef kdump_addr_t	cache_key_t;
  */
 #define DEFAULT_CACHE_SIZE	1024
 
+/** Default read-ahead window (in pages). */
+#define DEFAULT_CACHE_READAHEAD	8
+
 /**  Cache entry state.
  */
 enum cache_state {
@@ -1171,14 +1368,22 @@ enum cache_state {
 };
 
 /**  Cache entry.
+ *
+ * Entries are kept apart from the data they describe, and the fields
+ * are ordered so that an entry fits into 32 bytes on 64-bit systems,
+ * i.e. two entries share a cache line.
  */
 struct cache_entry {
 	cache_key_t key;	/**< Cache entry key. */
-	enum cache_state state;	/**< Cache entry state. */
+	void *data;		/**< Pointer to data. */
 	unsigned next;		/**< Index of next entry in evict list. */
 	unsigned prev;		/**< Index of previous entry in evict list. */
 	unsigned refcnt;	/**< Reference count. */
-	void *data;		/**< Pointer to data. */
+	unsigned char state;	/**< Cache entry state (@ref cache_state). */
+	bool precious : 1;	/**< On the precious list (or its ghost). */
+	bool busy : 1;		/**< Data is being loaded by a reader. */
+	bool readahead : 1;	/**< Loaded ahead, not accessed yet. */
+	bool referenced : 1;	/**< Hit since the last clock sweep. */
 };
 
 /** Cache entry destructor.
@@ -1189,19 +1394,57 @@ struct cache_entry {
 typedef void cache_entry_cleanup_fn(void *data, struct cache_entry *ce);
 
 INTERNAL_DECL(unsigned, get_cache_size, (kdump_ctx_t *ctx));
-INTERNAL_DECL(struct cache *, cache_alloc, (unsigned n, size_t size));
+INTERNAL_DECL(bool, get_cache_wait, (kdump_ctx_t *ctx));
+INTERNAL_DECL(bool, get_cache_hugepages, (kdump_ctx_t *ctx));
+INTERNAL_DECL(bool, get_cache_numa, (kdump_ctx_t *ctx));
+INTERNAL_DECL(const char *, get_cache_policy, (kdump_ctx_t *ctx));
+INTERNAL_DECL(unsigned, get_cache_max_size, (kdump_ctx_t *ctx));
+INTERNAL_DECL(kdump_num_t, get_cache_budget, (kdump_ctx_t *ctx));
+INTERNAL_DECL(struct cache *, cache_alloc,
+	      (unsigned n, unsigned max, size_t size, bool huge));
+INTERNAL_DECL(struct cache *, cache_alloc_node,
+	      (unsigned n, unsigned max, size_t size, bool huge,
+	       const struct numa_topology *numa, unsigned node));
 INTERNAL_DECL(void, set_cache_entry_cleanup,
 	      (struct cache *, cache_entry_cleanup_fn *, void *));
 INTERNAL_DECL(void, cache_free, (struct cache *));
 INTERNAL_DECL(void, cache_flush, (struct cache *));
 INTERNAL_DECL(struct cache_entry *, cache_get_entry,
 	      (struct cache *, cache_key_t));
+INTERNAL_DECL(struct cache_entry *, cache_get_readahead,
+	      (struct cache *, cache_key_t));
+INTERNAL_DECL(struct cache_entry *, cache_peek_entry,
+	      (struct cache *, cache_key_t));
+INTERNAL_DECL(struct cache_entry *, cache_find_entry,
+	      (struct cache *, cache_key_t));
 INTERNAL_DECL(void, cache_put_entry,
 	      (struct cache *cache, struct cache_entry *entry));
 INTERNAL_DECL(void, cache_insert, (struct cache *, struct cache_entry *));
 INTERNAL_DECL(void, cache_discard, (struct cache *, struct cache_entry *));
 
+/** Maximum number of entries processed by one batch operation. */
+#define CACHE_BATCH_MAX	16
+
+INTERNAL_DECL(void, cache_get_entries,
+	      (struct cache *cache, const cache_key_t *keys,
+	       struct cache_entry **entries, unsigned n));
+INTERNAL_DECL(void, cache_insert_entries,
+	      (struct cache *cache, struct cache_entry **entries, unsigned n));
+INTERNAL_DECL(void, cache_put_entries,
+	      (struct cache *cache, struct cache_entry **entries, unsigned n));
+INTERNAL_DECL(enum data_mode, cache_data_mode, (const struct cache *cache));
+INTERNAL_DECL(void, cache_set_wait, (struct cache *cache, bool wait));
+INTERNAL_DECL(unsigned, cache_capacity, (struct cache *cache));
+INTERNAL_DECL(bool, cache_set_policy,
+	      (struct cache *cache, const char *name));
+INTERNAL_DECL(void, cache_scale, (struct cache *cache, unsigned factor));
+INTERNAL_DECL(void, cache_update_stats, (struct cache *cache));
+INTERNAL_DECL(void, cache_set_attrs,
+	      (struct cache *cache, kdump_ctx_t *ctx, struct attr_data *dir));
+
 INTERNAL_DECL(kdump_status, def_realloc_caches, (kdump_ctx_t *ctx));
+INTERNAL_DECL(void, scale_caches, (struct kdump_shared *shared));
+INTERNAL_DECL(void, free_page_caches, (struct kdump_shared *shared));
 
 /**  Check if a cache entry is valid.
  *
@@ -1214,6 +1457,26 @@ cache_entry_valid(struct cache_entry *entry)
 	return entry->state == cs_valid;
 }
 
+/* Asynchronous I/O */
+
+/** Read request for @ref uring_read.
+ */
+struct uring_read {
+	void *buf;		/**< Target buffer. */
+	size_t len;		/**< Length of data. */
+	off_t pos;		/**< File position. */
+	int res;		/**< Bytes read, or negative error number. */
+};
+
+struct uring;
+
+INTERNAL_DECL(struct uring *, uring_new, (unsigned entries));
+INTERNAL_DECL(void, uring_free, (struct uring *ring));
+INTERNAL_DECL(int, uring_read,
+	      (struct uring *ring, int fd, struct uring_read *rd, unsigned n));
+INTERNAL_DECL(void, uring_advise,
+	      (struct uring *ring, int fd, off_t pos, off_t len));
+
 /* File cache */
 
 /** File cache entry.
@@ -1232,35 +1495,150 @@ struct fcache_entry {
 	struct cache *cache;
 };
 
+/** Number of sequential streams tracked by an adaptive file cache.
+ * A region miss is sequential if the region follows one of the most
+ * recently mapped regions.
+ */
+#define FCACHE_STREAMS		4
+
+/** Access pattern advice passed to the kernel.
+ */
+enum fcache_advice {
+	fa_normal,		/**< Default read-ahead. */
+	fa_sequential,		/**< Aggressive read-ahead. */
+	fa_random,		/**< No read-ahead. */
+};
+
 /** File cache.
  */
 struct fcache {
 	/** Reference counter. */
 	unsigned long refcnt;
 
+	/** Lock for looking up and filling cache entries. */
+	mutex_t mutex;
+
 	/** Open file descriptor. */
 	int fd;
 
 	/** Page size (in bytes). */
 	size_t pgsz;
 
-	/** Size of mmap'ed regions. */
+	/** Size of mmap'ed regions (1 << @c order pages). */
 	size_t mmapsz;
 
+	/** Current page order of mmap'ed regions. */
+	unsigned order;
+
+	/** Page order configured when the cache was created. */
+	unsigned base_order;
+
+	/** Maximum page order (equal to @c base_order if not adaptive). */
+	unsigned max_order;
+
+	/** Number of consecutive sequential region misses. */
+	unsigned seqmiss;
+
+	/** Number of consecutive non-sequential region misses. */
+	unsigned randmiss;
+
+	/** Index of the next slot in @c seqend. */
+	unsigned seqidx;
+
+	/** End offsets of recently mapped regions. */
+	off_t seqend[FCACHE_STREAMS];
+
 	/** File size (if known) or maximum off_t. */
 	off_t filesz;
 
-	/** Main cache (for mmap'ed regions). */
+	/** Mapping of the whole file, or @c NULL. */
+	void *map;
+
+	/** Main cache (for mmap'ed regions), or @c NULL. */
 	struct cache *cache;
 
+	/** io_uring instance for reading the fallback cache, or @c NULL. */
+	struct uring *ring;
+
+	/** Lock for submitting requests to @c ring.
+	 * This lock is not held together with @c mutex.
+	 */
+	mutex_t ring_mutex;
+
 	/** Fallback cache (for read regions). */
 	struct cache *fbcache;
+
+	/** Advice currently given to the kernel. */
+	enum fcache_advice advice;
+
+	/** Set if @c advice follows the detected access pattern. */
+	bool auto_advice;
+
+	/** Access pattern score (positive for sequential reads).
+	 * This field is updated atomically, without any lock.
+	 */
+	int pattern;
+
+	/** Total size of currently mmap'ed regions. */
+	kdump_num_t mapped;
+
+	/** Number of mmap calls for regions. */
+	unsigned long nmaps;
+
+	/** Number of munmap calls for regions. */
+	unsigned long nunmaps;
+
+	/** Total size of mmap'ed regions (for the attribute). */
+	kdump_attr_value_t bytes_mapped;
+
+	/** Number of mmap calls (for the attribute). */
+	kdump_attr_value_t maps;
+
+	/** Number of munmap calls (for the attribute). */
+	kdump_attr_value_t unmaps;
+
+	/** Name of the current advice (for the attribute). */
+	kdump_attr_value_t advice_name;
+
+	/** Free chunk buffers (see @ref fcache_get_chunk). */
+	struct fcache_buf *pool;
+
+	/** Number of buffers in @c pool. */
+	unsigned npool;
+
+	/** Total size of buffers in @c pool. */
+	size_t poolsz;
+
+	/** Number of heap allocations for chunk buffers. */
+	unsigned long nallocs;
+
+	/** Number of chunk buffer allocations (for the attribute). */
+	kdump_attr_value_t chunk_allocs;
 };
 
+/** Share of the cache budget reserved for the file cache.
+ * The file cache may use 1/2^n of the memory budget set by the
+ * "cache.budget" attribute. The page cache uses the rest.
+ */
+#define FCACHE_BUDGET_SHIFT	2
+
 INTERNAL_DECL(struct fcache *, fcache_new,
-	      (int fd, unsigned n, unsigned order));
+	      (int fd, unsigned n, unsigned order, bool adaptive,
+	       kdump_num_t budget));
+INTERNAL_DECL(bool, fcache_map_file, (struct fcache *fc));
+INTERNAL_DECL(bool, fcache_use_uring, (struct fcache *fc));
+INTERNAL_DECL(void, fcache_readahead,
+	      (struct fcache *fc, off_t pos, off_t len));
+INTERNAL_DECL(bool, fcache_advice_parse,
+	      (const char *name, enum fcache_advice *advice));
+INTERNAL_DECL(void, fcache_advise,
+	      (struct fcache *fc, enum fcache_advice advice));
+INTERNAL_DECL(void, fcache_note_access, (struct fcache *fc, bool seq));
 INTERNAL_DECL(void, fcache_free,
 	      (struct fcache *fc));
+INTERNAL_DECL(void, fcache_scale,
+	      (struct fcache *fc, unsigned factor));
+INTERNAL_DECL(void, fcache_update_stats, (struct fcache *fc));
 
 /** Increment file cache reference counter.
  * @param fc  File cache.
@@ -1299,7 +1677,8 @@ INTERNAL_DECL(kdump_status, fcache_get_fb,
 static inline void
 fcache_put(struct fcache_entry *fce)
 {
-	/* Cache may be NULL after a call to fcache_get_fb. */
+	/* Cache may be NULL after a call to fcache_get_fb,
+	 * or if the whole file is mapped. */
 	if (fce->cache)
 		cache_put_entry(fce->cache, fce->ce);
 }
@@ -1319,6 +1698,12 @@ struct fcache_chunk {
 	/** Number of cache entries. */
 	size_t nent;
 
+	/** File cache which owns the buffers of the chunk, or @c NULL.
+	 * If @c nent is zero and this field is @c NULL, @c data was
+	 * allocated with malloc().
+	 */
+	struct fcache *fc;
+
 	union {
 		/** File cache entries if @c nent <= @ref MAX_EMBED_FCES. */
 		struct fcache_entry embed_fces[MAX_EMBED_FCES];
@@ -1342,13 +1727,76 @@ struct page_io {
 	struct fcache_chunk chunk; /**< File cache chunk. */
 };
 
+/**  Page referenced by the application.
+ * @sa kdump_get_page
+ */
+struct _kdump_page {
+	kdump_addr_t addr;	/**< Page-aligned address before translation. */
+	struct page_io pio;	/**< Page I/O control (after translation). */
+};
+
+/**  Page pinned in the cache.
+ * @sa kdump_pin_range
+ */
+struct pinned_page {
+	kdump_addrspace_t as;	/**< Address space before translation. */
+	kdump_addr_t addr;	/**< Page-aligned address before translation. */
+	struct page_io pio;	/**< Page I/O control (after translation). */
+};
+
+INTERNAL_DECL(kdump_status, check_unpinned, (kdump_ctx_t *ctx));
+INTERNAL_DECL(void, unpin_all, (kdump_ctx_t *ctx));
+INTERNAL_DECL(void, l1_free, (kdump_ctx_t *ctx));
+INTERNAL_DECL(void, l1_flush, (struct kdump_shared *shared));
+INTERNAL_DECL(void, cached_reads_free, (kdump_ctx_t *ctx));
+INTERNAL_DECL(void, cached_reads_flush, (struct kdump_shared *shared));
+
 typedef kdump_status read_page_fn(
 	kdump_ctx_t *ctx, struct page_io *pio);
 
+INTERNAL_DECL(unsigned, cache_node, (kdump_ctx_t *ctx));
 INTERNAL_DECL(kdump_status, cache_get_page,
 	      (kdump_ctx_t *ctx, struct page_io *pio, read_page_fn *fn));
 INTERNAL_DECL(void, cache_put_page,
 	      (kdump_ctx_t *ctx, struct page_io *pio));
+INTERNAL_DECL(kdump_status, cache_get_pages,
+	      (kdump_ctx_t *ctx, struct page_io *pio, unsigned *pn,
+	       read_page_fn *fn));
+INTERNAL_DECL(void, cache_put_pages,
+	      (kdump_ctx_t *ctx, struct page_io *pio, unsigned n));
+INTERNAL_DECL(void, cache_read_ahead,
+	      (kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr,
+	       unsigned n, read_page_fn *fn));
+INTERNAL_DECL(void, prefetch_pages,
+	      (kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr,
+	       unsigned n));
+
+/* Prefetch worker pool */
+
+/** Maximum number of prefetch worker threads. */
+#define PREFETCH_THREADS_MAX	64
+
+/** Number of pending prefetch requests. */
+#define PREFETCH_QUEUE_LEN	64
+
+INTERNAL_DECL(kdump_status, prefetch_set_threads,
+	      (kdump_ctx_t *ctx, unsigned n));
+INTERNAL_DECL(bool, prefetch_submit,
+	      (kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr,
+	       unsigned n, read_page_fn *fn));
+INTERNAL_DECL(void, prefetch_free, (struct kdump_shared *shared));
+
+/* Persistent page cache */
+
+/** Default number of pages in a persistent cache. */
+#define PCACHE_DEFAULT_PAGES	65536
+
+INTERNAL_DECL(kdump_status, pcache_open, (kdump_ctx_t *ctx));
+INTERNAL_DECL(void, pcache_free, (struct pcache *pc));
+INTERNAL_DECL(bool, pcache_load,
+	      (kdump_ctx_t *ctx, kdump_pfn_t pfn, void *buf));
+INTERNAL_DECL(void, pcache_store,
+	      (kdump_ctx_t *ctx, kdump_pfn_t pfn, const void *buf));
 
 static inline
 void put_page(kdump_ctx_t *ctx, struct page_io *pio)
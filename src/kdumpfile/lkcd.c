@@ -705,10 +705,8 @@ lkcd_max_pfn_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
 		struct dump_page dummy_dp;
 		off_t dummy_off;
 
-		mutex_lock(&ctx->shared->cache_lock);
 		res = search_page_desc(ctx, ~(kdump_pfn_t)0,
 				       &dummy_dp, &dummy_off);
-		mutex_unlock(&ctx->shared->cache_lock);
 		if (res == KDUMP_ERR_NODATA) {
 			clear_error(ctx);
 			res = KDUMP_OK;
@@ -746,11 +744,9 @@ lkcd_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 	void *buf;
 	kdump_status ret;
 
-	mutex_lock(&ctx->shared->cache_lock);
 	off = 0;
 	pfn = pio->addr.addr >> get_page_shift(ctx);
 	ret = get_page_desc(ctx, pfn, &dp, &off);
-	mutex_unlock(&ctx->shared->cache_lock);
 	if (ret != KDUMP_OK)
 		return ret;
 
@@ -761,6 +757,8 @@ lkcd_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 			return set_error(ctx, KDUMP_ERR_CORRUPT,
 					 "Wrong compressed size: %lu",
 					 (unsigned long) dp.dp_size);
+		if (pcache_load(ctx, pfn, pio->chunk.data))
+			return KDUMP_OK;
 		buf = ctx->data[lkcdp->cbuf_slot];
 		break;
 	case DUMP_RAW:
@@ -776,9 +774,7 @@ lkcd_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 	}
 
 	/* read page data */
-	mutex_lock(&ctx->shared->cache_lock);
 	ret = fcache_pread(ctx->shared->fcache, buf, dp.dp_size, off);
-	mutex_unlock(&ctx->shared->cache_lock);
 	if (ret != KDUMP_OK)
 		return set_error(ctx, ret,
 				 "Cannot read page data at %llu",
@@ -806,6 +802,7 @@ lkcd_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 				 "Unknown compression method: %d",
 				 lkcdp->compression);
 
+	pcache_store(ctx, pfn, pio->chunk.data);
 	return KDUMP_OK;
 }
 
@@ -981,6 +978,10 @@ open_common(kdump_ctx_t *ctx, void *hdr)
 				lkcdp->version);
 	}
 
+	if (ret != KDUMP_OK)
+		goto err_free;
+
+	ret = pcache_open(ctx);
 	if (ret != KDUMP_OK)
 		goto err_free;
 
@@ -1078,6 +1079,7 @@ const struct format_ops lkcd_ops = {
 	.probe = lkcd_probe,
 	.get_page = lkcd_get_page,
 	.put_page = cache_put_page,
+	.read_page = lkcd_read_page,
 	.realloc_caches = def_realloc_caches,
 	.attr_cleanup = lkcd_attr_cleanup,
 	.cleanup = lkcd_cleanup,
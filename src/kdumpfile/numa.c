@@ -0,0 +1,287 @@
+/** @internal @file src/kdumpfile/numa.c
+ * @brief NUMA topology.
+ */
+/* Copyright (C) 2026 agent <agent@local>
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include "kdumpfile-priv.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/** Path to the NUMA node directory in sysfs. */
+#define SYSFS_NODE	"/sys/devices/system/node"
+
+/** Path to the CPU directory in sysfs. */
+#define SYSFS_CPU	"/sys/devices/system/cpu"
+
+/** Highest node number which can be used for memory placement. */
+#define NUMA_BIND_MAX	1024
+
+#ifndef MPOL_PREFERRED
+/** Memory policy: prefer allocations on the given node. */
+# define MPOL_PREFERRED	1
+#endif
+
+/**  Callback for each range of a sysfs list.
+ * @param first  First number in the range.
+ * @param last   Last number in the range.
+ * @param data   User-supplied data.
+ */
+typedef void list_range_fn(unsigned first, unsigned last, void *data);
+
+/**  Parse a list file from sysfs.
+ * @param path  Path to the file.
+ * @param fn    Callback for each range.
+ * @param data  User-supplied data, passed to @p fn.
+ * @returns     @c true on success, @c false if the file cannot be
+ *              read or parsed.
+ *
+ * The file contains a comma-separated list of numbers or ranges of
+ * numbers, e.g. "0-3,8,10-11".
+ */
+static bool
+parse_list(const char *path, list_range_fn *fn, void *data)
+{
+	char line[1024];
+	unsigned long first, last;
+	char *p, *end;
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (!f)
+		return false;
+	p = fgets(line, sizeof line, f);
+	fclose(f);
+	if (!p)
+		return false;
+
+	while (*p && *p != '\n') {
+		first = strtoul(p, &end, 10);
+		if (end == p || first > UINT_MAX)
+			return false;
+		last = first;
+		if (*end == '-') {
+			p = end + 1;
+			last = strtoul(p, &end, 10);
+			if (end == p || last > UINT_MAX || last < first)
+				return false;
+		}
+		fn(first, last, data);
+		p = end;
+		if (*p == ',')
+			++p;
+		else if (*p && *p != '\n')
+			return false;
+	}
+	return true;
+}
+
+/**  Find the highest number in a list.
+ * @param first  First number in the range (ignored).
+ * @param last   Last number in the range.
+ * @param data   Pointer to the count (highest number plus one).
+ */
+static void
+list_max(unsigned first, unsigned last, void *data)
+{
+	unsigned *pcount = data;
+	if (last >= *pcount)
+		*pcount = last + 1;
+}
+
+/**  Count the numbers in a list.
+ * @param first  First number in the range.
+ * @param last   Last number in the range.
+ * @param data   Pointer to the count.
+ */
+static void
+list_count(unsigned first, unsigned last, void *data)
+{
+	unsigned *pcount = data;
+	*pcount += last - first + 1;
+}
+
+/**  Helper data for collecting node numbers.
+ */
+struct node_list {
+	struct numa_topology *numa; /**< Topology being built. */
+	unsigned n;		    /**< Number of collected nodes. */
+};
+
+/**  Collect the system numbers of online nodes.
+ * @param first  First number in the range.
+ * @param last   Last number in the range.
+ * @param data   Node list (@ref node_list).
+ */
+static void
+list_nodes(unsigned first, unsigned last, void *data)
+{
+	struct node_list *list = data;
+
+	while (list->n < list->numa->nnodes && first <= last)
+		list->numa->node_id[list->n++] = first++;
+}
+
+/**  Helper data for mapping CPUs to nodes.
+ */
+struct cpu_list {
+	struct numa_topology *numa; /**< Topology being built. */
+	unsigned node;		    /**< Node index. */
+};
+
+/**  Assign CPUs to a node.
+ * @param first  First CPU in the range.
+ * @param last   Last CPU in the range.
+ * @param data   CPU list (@ref cpu_list).
+ */
+static void
+list_cpus(unsigned first, unsigned last, void *data)
+{
+	struct cpu_list *list = data;
+
+	for ( ; first <= last && first < list->numa->ncpus; ++first)
+		list->numa->cpu_node[first] = list->node;
+}
+
+/**  Read the NUMA topology of the running system.
+ * @returns  Topology, or @c NULL if it cannot be read.
+ *
+ * Nodes are numbered consecutively in the returned object, i.e.
+ * node indices do not have to match the system node numbers. CPUs
+ * which are not listed under any node are assigned to the first one.
+ *
+ * The result must be freed with @ref numa_topology_free.
+ */
+struct numa_topology *
+numa_topology_read(void)
+{
+	struct numa_topology *numa;
+	struct node_list nodes;
+	struct cpu_list cpus;
+	unsigned nnodes, ncpus;
+	char path[sizeof(SYSFS_NODE "/node/cpulist") + 3 * sizeof(unsigned)];
+
+	ncpus = 0;
+	if (!parse_list(SYSFS_CPU "/possible", list_max, &ncpus) || !ncpus)
+		return NULL;
+	nnodes = 0;
+	if (!parse_list(SYSFS_NODE "/online", list_count, &nnodes) ||
+	    !nnodes)
+		return NULL;
+
+	numa = calloc(1, sizeof(struct numa_topology) +
+		      ncpus * sizeof(unsigned));
+	if (!numa)
+		return NULL;
+	numa->node_id = calloc(nnodes, sizeof(unsigned));
+	if (!numa->node_id)
+		goto err;
+	numa->nnodes = nnodes;
+	numa->ncpus = ncpus;
+
+	nodes.numa = numa;
+	nodes.n = 0;
+	if (!parse_list(SYSFS_NODE "/online", list_nodes, &nodes) ||
+	    nodes.n != nnodes)
+		goto err;
+
+	cpus.numa = numa;
+	for (cpus.node = 0; cpus.node < nnodes; ++cpus.node) {
+		sprintf(path, SYSFS_NODE "/node%u/cpulist",
+			numa->node_id[cpus.node]);
+		parse_list(path, list_cpus, &cpus);
+	}
+
+	return numa;
+
+ err:
+	numa_topology_free(numa);
+	return NULL;
+}
+
+/**  Free a NUMA topology object.
+ * @param numa  Topology returned by @ref numa_topology_read.
+ */
+void
+numa_topology_free(struct numa_topology *numa)
+{
+	free(numa->node_id);
+	free(numa);
+}
+
+/**  Get the node of the calling thread.
+ * @param numa  NUMA topology.
+ * @returns     Index of the node which runs the calling thread.
+ *
+ * If the current CPU cannot be determined, the first node is returned.
+ */
+unsigned
+numa_local_node(const struct numa_topology *numa)
+{
+#ifdef __linux__
+	int cpu = sched_getcpu();
+	if (cpu >= 0 && (unsigned)cpu < numa->ncpus)
+		return numa->cpu_node[cpu];
+#endif
+	return 0;
+}
+
+/**  Prefer a NUMA node for a memory range.
+ * @param numa  NUMA topology.
+ * @param node  Node index.
+ * @param ptr   Start of the range (page-aligned).
+ * @param len   Length of the range.
+ * @returns     @c true on success, @c false if not supported.
+ *
+ * Memory which has not been touched yet is allocated from @p node
+ * if possible. Other nodes are used when it runs out of memory.
+ */
+bool
+numa_bind(const struct numa_topology *numa, unsigned node,
+	  void *ptr, size_t len)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+	unsigned long mask[NUMA_BIND_MAX / (CHAR_BIT * sizeof(long))] = { 0 };
+	unsigned id = numa->node_id[node];
+
+	if (id >= NUMA_BIND_MAX)
+		return false;
+	mask[id / (CHAR_BIT * sizeof(long))] |=
+		1UL << (id % (CHAR_BIT * sizeof(long)));
+	return !syscall(SYS_mbind, ptr, len, MPOL_PREFERRED,
+			mask, NUMA_BIND_MAX + 1, 0);
+#else
+	return false;
+#endif
+}
@@ -57,6 +57,19 @@
  */
 #define FCACHE_ORDER	10
 
+/** Maximum file cache page order.
+ * The "fcache.mmap.order" attribute cannot be set higher than this.
+ * With 4K pages, this limit corresponds to 4G blocks.
+ */
+#define FCACHE_MAX_ORDER	20
+
+/** Maximum size of a dump file which is mapped as a whole by default.
+ * Mapping the whole file avoids all file cache lookups, but it needs
+ * page tables for the whole file, so bigger files are mapped in
+ * regions of @ref FCACHE_ORDER pages.
+ */
+#define FCACHE_MAP_FILE_MAX	(64ULL << 30)
+
 static kdump_status kdump_open_known(kdump_ctx_t *pctx);
 
 static const struct format_ops *formats[] = {
@@ -72,6 +85,141 @@ static const struct format_ops *formats[] = {
 	&devmem_ops
 };
 
+/**  Decide whether the whole dump file should be mapped.
+ * @param ctx  Dump file object.
+ * @param fc   File cache of the dump file.
+ * @returns    @c true if the whole file should be mapped.
+ *
+ * If "fcache.map_file" is set, its value is used. Otherwise, regular
+ * files up to @ref FCACHE_MAP_FILE_MAX bytes are mapped as a whole on
+ * 64-bit hosts, unless the mapping would exceed the file cache share
+ * of "cache.budget".
+ */
+static bool
+want_map_file(kdump_ctx_t *ctx, const struct fcache *fc)
+{
+	struct attr_data *attr = gattr(ctx, GKI_fcache_map_file);
+	kdump_num_t budget;
+
+	if (attr_isset(attr))
+		return !!attr_value(attr)->number;
+
+	budget = get_cache_budget(ctx) >> FCACHE_BUDGET_SHIFT;
+	return sizeof(void *) >= 8 &&
+		(unsigned long long)fc->filesz <= FCACHE_MAP_FILE_MAX &&
+		(!budget || (unsigned long long)fc->filesz <= budget);
+}
+
+/**  Get the configured page order of file cache regions.
+ * @param ctx  Dump file object.
+ * @returns    Page order from "fcache.mmap.order", or @ref FCACHE_ORDER.
+ */
+static unsigned
+get_fcache_order(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_fcache_mmap_order);
+	return attr_isset(attr)
+		? attr_value(attr)->number
+		: FCACHE_ORDER;
+}
+
+/**  Get the configured number of file cache regions.
+ * @param ctx  Dump file object.
+ * @returns    Number from "fcache.mmap.windows", or @ref FCACHE_SIZE.
+ */
+static unsigned
+get_fcache_windows(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_fcache_mmap_windows);
+	return attr_isset(attr)
+		? attr_value(attr)->number
+		: FCACHE_SIZE;
+}
+
+/**  Get the configured adaptive mode of the file cache.
+ * @param ctx  Dump file object.
+ * @returns    @c true if "fcache.mmap.adaptive" is set to non-zero.
+ */
+static bool
+get_fcache_adaptive(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_fcache_mmap_adaptive);
+	return attr_isset(attr)
+		? !!attr_value(attr)->number
+		: false;
+}
+
+/**  Get the configured io_uring mode of the file cache.
+ * @param ctx  Dump file object.
+ * @returns    @c true if "fcache.io_uring" is set to non-zero.
+ */
+static bool
+get_fcache_uring(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_fcache_io_uring);
+	return attr_isset(attr)
+		? !!attr_value(attr)->number
+		: false;
+}
+
+/**  Get the configured access pattern advice of the file cache.
+ * @param ctx     Dump file object.
+ * @param fixed   Set to @c false if the advice is automatic.
+ * @param advice  Advice, set if not automatic.
+ * @returns       Error status.
+ *
+ * If "fcache.advice" is not set, the advice is automatic (as if it was
+ * set to "auto").
+ */
+static kdump_status
+get_fcache_advice(kdump_ctx_t *ctx, bool *fixed, enum fcache_advice *advice)
+{
+	struct attr_data *attr = gattr(ctx, GKI_fcache_advice);
+	const char *name;
+
+	*fixed = false;
+	if (!attr_isset(attr))
+		return KDUMP_OK;
+	name = attr_value(attr)->string;
+	if (!strcmp(name, "auto"))
+		return KDUMP_OK;
+	*fixed = true;
+	if (!fcache_advice_parse(name, advice))
+		return set_error(ctx, KDUMP_ERR_INVALID,
+				 "Unknown file cache advice: %s", name);
+	return KDUMP_OK;
+}
+
+/**  Get the name of the file cache backend.
+ * @param fc  File cache.
+ * @returns   Backend name (for the "fcache.backend" attribute).
+ */
+static const char *
+fcache_backend_name(const struct fcache *fc)
+{
+	if (fc->ring)
+		return "io_uring";
+	if (fc->map || fc->cache)
+		return "mmap";
+	return "pread";
+}
+
+/**  Check that the dump file descriptor can be changed.
+ * @param ctx     Dump file object.
+ * @param attr    File descriptor attribute.
+ * @param newval  New file descriptor.
+ * @returns       Error status.
+ *
+ * The file cache and the page caches are replaced, so this is refused
+ * while any pages are pinned.
+ */
+static kdump_status
+file_fd_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
+		 kdump_attr_value_t *newval)
+{
+	return check_unpinned(ctx);
+}
+
 /**  Set dump file descriptor.
  * @param ctx   Dump file object.
  * @returns     Error status.
@@ -81,18 +229,46 @@ static const struct format_ops *formats[] = {
 static kdump_status
 file_fd_post_hook(kdump_ctx_t *ctx, struct attr_data *attr)
 {
+	unsigned order = get_fcache_order(ctx);
+	unsigned windows = get_fcache_windows(ctx);
+	enum fcache_advice advice;
+	bool fixed_advice;
 	kdump_status ret;
 	int i;
 
+	if (order > FCACHE_MAX_ORDER)
+		return set_error(ctx, KDUMP_ERR_INVALID,
+				 "File cache order too big: %u > %u",
+				 order, FCACHE_MAX_ORDER);
+	if (!windows)
+		return set_error(ctx, KDUMP_ERR_INVALID,
+				 "File cache needs at least one window");
+	ret = get_fcache_advice(ctx, &fixed_advice, &advice);
+	if (ret != KDUMP_OK)
+		return ret;
+
 	if (ctx->shared->fcache)
 		fcache_decref(ctx->shared->fcache);
 	ctx->shared->fcache = fcache_new(get_file_fd(ctx),
-					 FCACHE_SIZE, FCACHE_ORDER);
+					 windows, order,
+					 get_fcache_adaptive(ctx),
+					 get_cache_budget(ctx) >>
+					 FCACHE_BUDGET_SHIFT);
 	if (!ctx->shared->fcache)
 		return set_error(ctx, KDUMP_ERR_SYSTEM,
 				 "Cannot allocate file cache");
+	/* With io_uring, all data is read, so the file is not mapped. */
+	if (!get_fcache_uring(ctx) ||
+	    !fcache_use_uring(ctx->shared->fcache)) {
+		if (want_map_file(ctx, ctx->shared->fcache))
+			fcache_map_file(ctx->shared->fcache);
+	}
+	if (fixed_advice)
+		fcache_advise(ctx->shared->fcache, advice);
 
 	ctx->xlat->dirty = true;
+	cached_reads_flush(ctx->shared);
+	l1_flush(ctx->shared);
 
 	for (i = 0; i < ARRAY_SIZE(formats); ++i) {
 		ctx->shared->ops = formats[i];
@@ -102,11 +278,10 @@ file_fd_post_hook(kdump_ctx_t *ctx, struct attr_data *attr)
 		if (ret != KDUMP_NOPROBE)
 			return ret;
 
+		cached_reads_flush(ctx->shared);
+		l1_flush(ctx->shared);
 		ctx->shared->ops = NULL;
-		if (ctx->shared->cache) {
-			cache_free(ctx->shared->cache);
-			ctx->shared->cache = NULL;
-		}
+		free_page_caches(ctx->shared);
 		clear_volatile_attrs(ctx);
 		clear_error(ctx);
 	}
@@ -119,11 +294,32 @@ kdump_open_known(kdump_ctx_t *ctx)
 {
 	set_attr_static_string(ctx, gattr(ctx, GKI_file_format),
 			       ATTR_DEFAULT, ctx->shared->ops->name);
+	set_attr_static_string(ctx, gattr(ctx, GKI_fcache_backend),
+			       ATTR_DEFAULT,
+			       fcache_backend_name(ctx->shared->fcache));
+	set_attr(ctx, gattr(ctx, GKI_fcache_bytes_mapped),
+		 ATTR_INDIRECT, &ctx->shared->fcache->bytes_mapped);
+	set_attr(ctx, gattr(ctx, GKI_fcache_mmap_maps),
+		 ATTR_INDIRECT, &ctx->shared->fcache->maps);
+	set_attr(ctx, gattr(ctx, GKI_fcache_mmap_unmaps),
+		 ATTR_INDIRECT, &ctx->shared->fcache->unmaps);
+	set_attr(ctx, gattr(ctx, GKI_fcache_current_advice),
+		 ATTR_INDIRECT, &ctx->shared->fcache->advice_name);
+	set_attr(ctx, gattr(ctx, GKI_fcache_chunk_allocs),
+		 ATTR_INDIRECT, &ctx->shared->fcache->chunk_allocs);
+	set_attr(ctx, gattr(ctx, GKI_cache_pinned_bytes),
+		 ATTR_INDIRECT, &ctx->shared->pinned_bytes);
+	if (ctx->shared->fcache->cache)
+		cache_set_attrs(ctx->shared->fcache->cache, ctx,
+				gattr(ctx, GKI_dir_fcache_mmap));
+	cache_set_attrs(ctx->shared->fcache->fbcache, ctx,
+			gattr(ctx, GKI_dir_fcache_fallback));
 
 	return KDUMP_OK;
 }
 
 const struct attr_ops file_fd_ops = {
+	.pre_set = file_fd_pre_hook,
 	.post_set = file_fd_post_hook,
 };
 
@@ -415,6 +611,11 @@ kdump_free(kdump_ctx_t *ctx)
 
 	rwlock_wrlock(&shared->lock);
 
+	unpin_all(ctx);
+	l1_free(ctx);
+	cached_reads_free(ctx);
+	shared->remote_hits += ctx->remote_hits;
+
 	for (slot = 0; slot < PER_CTX_SLOTS; ++slot)
 		if (shared->per_ctx_size[slot])
 			free(ctx->data[slot]);
@@ -0,0 +1,494 @@
+/** @internal @file src/kdumpfile/pcache.c
+ * @brief Persistent cache of decompressed pages.
+ */
+/* Copyright (C) 2026 agent <agent@local>
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include "kdumpfile-priv.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** Magic string at the beginning of a persistent cache file. */
+#define PCACHE_MAGIC		"KDPCACHE"
+
+/** Version of the persistent cache file format. */
+#define PCACHE_VERSION		2
+
+/** Size of the file header. */
+#define PCACHE_HDR_SIZE		4096
+
+/** Number of bytes at the beginning of a dump file used to identify it. */
+#define PCACHE_IDENT_SIZE	4096
+
+/** Minimum number of slots (as a power of two). */
+#define PCACHE_SLOT_BITS_MIN	4
+
+/** Maximum number of slots (as a power of two). */
+#define PCACHE_SLOT_BITS_MAX	30
+
+/**  Identity of a dump file.
+ *
+ * If any of these values changes, all cached pages are invalid.
+ */
+struct pcache_ident {
+	uint64_t size;		/**< Dump file size. */
+	int64_t mtime_sec;	/**< Modification time (seconds). */
+	int64_t mtime_nsec;	/**< Modification time (nanoseconds). */
+	uint32_t page_size;	/**< Page size. */
+	uint32_t csum;		/**< Checksum of the dump file header. */
+};
+
+/**  Persistent cache file header.
+ */
+struct pcache_header {
+	char magic[8];		/**< Must be @ref PCACHE_MAGIC. */
+	uint32_t version;	/**< Must be @ref PCACHE_VERSION. */
+	uint32_t gen;		/**< Generation; changed on invalidation. */
+	uint32_t slot_bits;	/**< Number of slots as a power of two. */
+	uint32_t pad;		/**< Reserved (zero). */
+	struct pcache_ident ident; /**< Identity of the cached dump file. */
+};
+
+/**  Persistent cache slot.
+ *
+ * A slot is valid if its key and generation match. To update a slot,
+ * the writer first sets the key to zero, then writes the data and the
+ * checksum, and finally sets the key. A reader checks the key before
+ * and after copying the data, and verifies the checksum, so torn
+ * reads and concurrent updates (even from other processes) are
+ * detected without any locking.
+ *
+ * The checksum also covers the page frame number and the generation.
+ * If two writers interleave, the key of one of them may be stored
+ * together with the data and checksum of the other, and such a slot
+ * must not be valid.
+ */
+struct pcache_slot {
+	uint64_t key;		/**< Page frame number plus one, or zero. */
+	uint32_t gen;		/**< Generation of the writer. */
+	uint32_t csum;		/**< Checksum of the slot. */
+};
+
+/**  Persistent page cache.
+ *
+ * The cache file is mapped into memory. Pages are stored in a
+ * direct-mapped table, i.e. each page frame number can be stored in
+ * exactly one slot, and a newer page simply replaces an older one.
+ */
+struct pcache {
+	void *map;		/**< Mapped cache file. */
+	size_t mapsize;		/**< Size of the mapping. */
+	volatile struct pcache_slot *slot; /**< Slot table. */
+	char *data;		/**< Page data. */
+	unsigned slot_bits;	/**< Number of slots as a power of two. */
+	size_t page_size;	/**< Page size. */
+	uint32_t gen;		/**< Generation at open time. */
+
+	mutex_t mutex;		/**< Lock for the statistics. */
+	unsigned long nhits;	/**< Number of pages found in the cache. */
+	unsigned long nmisses;	/**< Number of pages not found. */
+
+	kdump_attr_value_t hits;   /**< Value of the "hits" attribute. */
+	kdump_attr_value_t misses; /**< Value of the "misses" attribute. */
+};
+
+/**  Compute the checksum of a slot.
+ * @param data  Page data.
+ * @param size  Page size (a multiple of 8).
+ * @param pfn   Page frame number.
+ * @param gen   Generation.
+ * @returns     Checksum.
+ */
+static uint32_t
+page_csum(const void *data, size_t size, kdump_pfn_t pfn, uint32_t gen)
+{
+	const uint64_t *p = data;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	hash ^= pfn;
+	hash *= 0x100000001b3ULL;
+	hash ^= gen;
+	hash *= 0x100000001b3ULL;
+
+	for (size /= sizeof(uint64_t); size; --size) {
+		hash ^= *p++;
+		hash *= 0x100000001b3ULL;
+	}
+	return hash ^ (hash >> 32);
+}
+
+/**  Get the identity of the dump file.
+ * @param ctx    Dump file object.
+ * @param ident  Identity (filled in on success).
+ * @returns      Error status.
+ */
+static kdump_status
+get_ident(kdump_ctx_t *ctx, struct pcache_ident *ident)
+{
+	char buf[PCACHE_IDENT_SIZE];
+	struct stat st;
+	ssize_t rd;
+
+	if (fstat(get_file_fd(ctx), &st))
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot stat dump file: %s",
+				 strerror(errno));
+
+	rd = pread(get_file_fd(ctx), buf, sizeof buf, 0);
+	if (rd < 0)
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot read dump file header: %s",
+				 strerror(errno));
+
+	memset(ident, 0, sizeof *ident);
+	ident->size = st.st_size;
+	ident->mtime_sec = st.st_mtim.tv_sec;
+	ident->mtime_nsec = st.st_mtim.tv_nsec;
+	ident->page_size = get_page_size(ctx);
+	ident->csum = cksum32(buf, rd, 0);
+	return KDUMP_OK;
+}
+
+/**  Get the requested number of persistent cache slots.
+ * @param ctx  Dump file object.
+ * @returns    Number of slots as a power of two.
+ */
+static unsigned
+get_slot_bits(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_cache_persistent_pages);
+	kdump_num_t pages = PCACHE_DEFAULT_PAGES;
+	unsigned bits;
+
+	if (attr_isset(attr) && attr_revalidate(ctx, attr) == KDUMP_OK)
+		pages = attr_value(attr)->number;
+
+	bits = PCACHE_SLOT_BITS_MIN;
+	while (bits < PCACHE_SLOT_BITS_MAX && (1ULL << bits) < pages)
+		++bits;
+	return bits;
+}
+
+/**  Map the persistent cache file.
+ * @param ctx   Dump file object.
+ * @param pc    Persistent cache (@c slot_bits and @c page_size set).
+ * @param path  Cache file name.
+ * @param ident Identity of the dump file.
+ * @returns     Error status.
+ *
+ * The file is created if it does not exist. If it belongs to a
+ * different dump file (or to a different version of the same file),
+ * its generation is incremented, which invalidates all slots.
+ * The file is locked while the header is checked, so concurrent
+ * openers agree on the generation.
+ */
+static kdump_status
+map_file(kdump_ctx_t *ctx, struct pcache *pc, const char *path,
+	 const struct pcache_ident *ident)
+{
+	struct pcache_header *hdr;
+	size_t slotsize, dataoff;
+	struct stat st;
+	kdump_status ret;
+	int fd;
+
+	slotsize = sizeof(struct pcache_slot) << pc->slot_bits;
+	dataoff = PCACHE_HDR_SIZE + slotsize;
+	dataoff = (dataoff + pc->page_size - 1) & ~(pc->page_size - 1);
+	pc->mapsize = dataoff + (pc->page_size << pc->slot_bits);
+
+	fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if (fd < 0)
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot open %s: %s", path, strerror(errno));
+
+	if (flock(fd, LOCK_EX)) {
+		ret = set_error(ctx, KDUMP_ERR_SYSTEM,
+				"Cannot lock %s: %s", path, strerror(errno));
+		goto out;
+	}
+
+	/* Never shrink the file; other processes may have it mapped. */
+	if (fstat(fd, &st) ||
+	    (st.st_size < (off_t)pc->mapsize &&
+	     ftruncate(fd, pc->mapsize))) {
+		ret = set_error(ctx, KDUMP_ERR_SYSTEM,
+				"Cannot resize %s: %s", path, strerror(errno));
+		goto out;
+	}
+
+	pc->map = mmap(NULL, pc->mapsize, PROT_READ | PROT_WRITE,
+		       MAP_SHARED, fd, 0);
+	if (pc->map == MAP_FAILED) {
+		pc->map = NULL;
+		ret = set_error(ctx, KDUMP_ERR_SYSTEM,
+				"Cannot map %s: %s", path, strerror(errno));
+		goto out;
+	}
+
+	hdr = pc->map;
+	if (memcmp(hdr->magic, PCACHE_MAGIC, sizeof hdr->magic) ||
+	    hdr->version != PCACHE_VERSION) {
+		memset(hdr, 0, sizeof *hdr);
+		memcpy(hdr->magic, PCACHE_MAGIC, sizeof hdr->magic);
+		hdr->version = PCACHE_VERSION;
+	}
+	if (!hdr->gen || hdr->slot_bits != pc->slot_bits ||
+	    memcmp(&hdr->ident, ident, sizeof *ident)) {
+		hdr->ident = *ident;
+		hdr->slot_bits = pc->slot_bits;
+		if (!++hdr->gen)
+			++hdr->gen;
+	}
+	pc->gen = hdr->gen;
+	pc->slot = pc->map + PCACHE_HDR_SIZE;
+	pc->data = pc->map + dataoff;
+	ret = KDUMP_OK;
+
+ out:
+	close(fd);		/* This also drops the lock. */
+	return ret;
+}
+
+/**  Free a persistent cache.
+ * @param pc  Persistent cache.
+ */
+void
+pcache_free(struct pcache *pc)
+{
+	munmap(pc->map, pc->mapsize);
+	mutex_destroy(&pc->mutex);
+	free(pc);
+}
+
+/**  Close the persistent cache of a dump file object.
+ * @param ctx  Dump file object.
+ */
+static void
+pcache_close(kdump_ctx_t *ctx)
+{
+	if (!ctx->shared->pcache)
+		return;
+
+	clear_attr(ctx, gattr(ctx, GKI_cache_persistent_hits));
+	clear_attr(ctx, gattr(ctx, GKI_cache_persistent_misses));
+	pcache_free(ctx->shared->pcache);
+	ctx->shared->pcache = NULL;
+}
+
+/**  Open the persistent cache.
+ * @param ctx  Dump file object.
+ * @returns    Error status.
+ *
+ * If @c cache.persistent.path is set, open (or create) the cache file
+ * for the current dump file. Otherwise, close the persistent cache.
+ * Formats which decompress pages call this function when a dump file
+ * is opened.
+ */
+kdump_status
+pcache_open(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_cache_persistent_path);
+	struct pcache_ident ident;
+	struct pcache *pc;
+	kdump_status ret;
+
+	pcache_close(ctx);
+	if (!attr_isset(attr))
+		return KDUMP_OK;
+
+	ret = get_ident(ctx, &ident);
+	if (ret != KDUMP_OK)
+		return ret;
+
+	pc = calloc(1, sizeof *pc);
+	if (!pc)
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot allocate persistent cache");
+	if (mutex_init(&pc->mutex, NULL)) {
+		free(pc);
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot initialize persistent cache mutex");
+	}
+	pc->slot_bits = get_slot_bits(ctx);
+	pc->page_size = get_page_size(ctx);
+
+	ret = map_file(ctx, pc, attr_value(attr)->string, &ident);
+	if (ret != KDUMP_OK) {
+		mutex_destroy(&pc->mutex);
+		free(pc);
+		return ret;
+	}
+
+	ctx->shared->pcache = pc;
+	set_attr(ctx, gattr(ctx, GKI_cache_persistent_hits),
+		 ATTR_INDIRECT, &pc->hits);
+	set_attr(ctx, gattr(ctx, GKI_cache_persistent_misses),
+		 ATTR_INDIRECT, &pc->misses);
+	return KDUMP_OK;
+}
+
+/**  Get the slot for a page frame.
+ * @param pc   Persistent cache.
+ * @param pfn  Page frame number.
+ * @returns    Slot index.
+ */
+static inline unsigned long
+pfn_slot(const struct pcache *pc, kdump_pfn_t pfn)
+{
+	return fold_hash(pfn, pc->slot_bits);
+}
+
+/**  Load a page from the persistent cache.
+ * @param ctx  Dump file object.
+ * @param pfn  Page frame number.
+ * @param buf  Page buffer.
+ * @returns    @c true if the page was found, @c false otherwise.
+ */
+bool
+pcache_load(kdump_ctx_t *ctx, kdump_pfn_t pfn, void *buf)
+{
+	struct pcache *pc = ctx->shared->pcache;
+	volatile struct pcache_slot *slot;
+	unsigned long idx;
+	uint32_t csum;
+	bool hit;
+
+	if (!pc || pc->page_size != get_page_size(ctx))
+		return false;
+
+	idx = pfn_slot(pc, pfn);
+	slot = &pc->slot[idx];
+	hit = false;
+	if (slot->key == pfn + 1 && slot->gen == pc->gen) {
+		__sync_synchronize();
+		csum = slot->csum;
+		memcpy(buf, pc->data + idx * pc->page_size, pc->page_size);
+		__sync_synchronize();
+		hit = slot->key == pfn + 1 && slot->gen == pc->gen &&
+			page_csum(buf, pc->page_size, pfn, pc->gen) == csum;
+	}
+
+	mutex_lock(&pc->mutex);
+	if (hit)
+		++pc->nhits;
+	else
+		++pc->nmisses;
+	mutex_unlock(&pc->mutex);
+
+	return hit;
+}
+
+/**  Store a page in the persistent cache.
+ * @param ctx  Dump file object.
+ * @param pfn  Page frame number.
+ * @param buf  Page data.
+ */
+void
+pcache_store(kdump_ctx_t *ctx, kdump_pfn_t pfn, const void *buf)
+{
+	struct pcache *pc = ctx->shared->pcache;
+	volatile struct pcache_slot *slot;
+	unsigned long idx;
+
+	if (!pc || pc->page_size != get_page_size(ctx))
+		return;
+
+	idx = pfn_slot(pc, pfn);
+	slot = &pc->slot[idx];
+	if (slot->key == pfn + 1 && slot->gen == pc->gen)
+		return;
+
+	slot->key = 0;
+	__sync_synchronize();
+	memcpy(pc->data + idx * pc->page_size, buf, pc->page_size);
+	slot->gen = pc->gen;
+	slot->csum = page_csum(buf, pc->page_size, pfn, pc->gen);
+	__sync_synchronize();
+	slot->key = pfn + 1;
+}
+
+static kdump_status
+pcache_path_post_hook(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	return ctx->shared->pcache
+		? pcache_open(ctx)
+		: KDUMP_OK;
+}
+
+static void
+pcache_path_clear_hook(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	pcache_close(ctx);
+}
+
+const struct attr_ops pcache_path_ops = {
+	.post_set = pcache_path_post_hook,
+	.pre_clear = pcache_path_clear_hook,
+};
+
+static kdump_status
+pcache_pages_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
+		      kdump_attr_value_t *val)
+{
+	if (!val->number)
+		return set_error(ctx, KDUMP_ERR_INVALID,
+				 "Persistent cache cannot be empty");
+	return KDUMP_OK;
+}
+
+const struct attr_ops pcache_pages_ops = {
+	.pre_set = pcache_pages_pre_hook,
+	.post_set = pcache_path_post_hook,
+};
+
+static kdump_status
+pcache_stats_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	struct pcache *pc = ctx->shared->pcache;
+
+	if (pc) {
+		mutex_lock(&pc->mutex);
+		pc->hits.number = pc->nhits;
+		pc->misses.number = pc->nmisses;
+		mutex_unlock(&pc->mutex);
+	}
+	return KDUMP_OK;
+}
+
+const struct attr_ops pcache_stats_ops = {
+	.revalidate = pcache_stats_revalidate,
+};
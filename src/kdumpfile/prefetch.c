@@ -0,0 +1,355 @@
+/** @internal @file src/kdumpfile/prefetch.c
+ * @brief Background prefetch worker pool.
+ */
+/* Copyright (C) 2026 agent <agent@local>
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include "kdumpfile-priv.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/**  Pending prefetch request.
+ */
+struct prefetch_job {
+	addrxlat_fulladdr_t addr; /**< Address of the first page. */
+	unsigned n;		  /**< Number of pages. */
+	read_page_fn *fn;	  /**< Read function, or @c NULL to load
+				   *   pages with the @c get_page method. */
+	unsigned node;		  /**< Page cache partition of the
+				   *   requesting object. */
+
+	/** Format operations at the time of the request.
+	 * The request is dropped if the format changes before it is
+	 * serviced, because @c fn is no longer valid in that case.
+	 */
+	const struct format_ops *ops;
+};
+
+/**  Prefetch worker pool.
+ *
+ * Worker threads are detached. A worker exits when there are more
+ * running workers than requested, so the pool can shrink without
+ * waiting for the workers while the shared data is locked.
+ */
+struct prefetch_pool {
+	mutex_t mutex;		/**< Lock for this structure. */
+	cond_t cond;		/**< Signalled when a job is queued or
+				 *   when the pool should shrink. */
+	cond_t idle;		/**< Signalled when a worker exits. */
+
+	unsigned nthreads;	/**< Requested number of workers. */
+	unsigned nrunning;	/**< Number of running workers. */
+
+	unsigned head;		/**< Index of the oldest queued job. */
+	unsigned njobs;		/**< Number of queued jobs. */
+	struct prefetch_job job[PREFETCH_QUEUE_LEN]; /**< Job queue. */
+};
+
+/**  Allocate per-context data for a worker.
+ * @param ctx  Private dump file object.
+ * @returns    @c true on success, @c false on allocation failure.
+ *
+ * The sizes may change while the shared data is write-locked, so
+ * workers allocate per-context data for each job.
+ */
+static bool
+alloc_worker_data(kdump_ctx_t *ctx)
+{
+	int slot;
+
+	for (slot = 0; slot < PER_CTX_SLOTS; ++slot) {
+		size_t sz = ctx->shared->per_ctx_size[slot];
+		ctx->data[slot] = sz ? malloc(sz) : NULL;
+		if (sz && !ctx->data[slot]) {
+			while (slot-- > 0)
+				free(ctx->data[slot]);
+			return false;
+		}
+	}
+	return true;
+}
+
+/**  Free per-context data of a worker.
+ * @param ctx  Private dump file object.
+ */
+static void
+free_worker_data(kdump_ctx_t *ctx)
+{
+	int slot;
+
+	for (slot = 0; slot < PER_CTX_SLOTS; ++slot)
+		free(ctx->data[slot]);
+}
+
+/**  Service a prefetch request.
+ * @param ctx  Private dump file object.
+ * @param job  Prefetch request.
+ */
+static void
+run_job(kdump_ctx_t *ctx, const struct prefetch_job *job)
+{
+	struct kdump_shared *shared = ctx->shared;
+
+	rwlock_rdlock(&shared->lock);
+	if (shared->ops == job->ops && shared->cache &&
+	    alloc_worker_data(ctx)) {
+		ctx->numa_node = job->node;
+		if (job->fn)
+			cache_read_ahead(ctx, &job->addr, job->n, job->fn);
+		else
+			prefetch_pages(ctx, &job->addr, job->n);
+		free_worker_data(ctx);
+	}
+	rwlock_unlock(&shared->lock);
+}
+
+/**  Prefetch worker thread.
+ * @param arg  Shared data of a dump file object.
+ * @returns    Always @c NULL.
+ */
+static void *
+prefetch_worker(void *arg)
+{
+	struct kdump_shared *shared = arg;
+	struct prefetch_pool *pool = shared->prefetch;
+	struct prefetch_job job;
+	kdump_ctx_t *ctx;
+
+	ctx = alloc_private_ctx(shared);
+	if (ctx)
+		ctx->ra.disabled = true;
+
+	mutex_lock(&pool->mutex);
+	while (ctx && pool->nrunning <= pool->nthreads) {
+		if (!pool->njobs) {
+			cond_wait(&pool->cond, &pool->mutex);
+			continue;
+		}
+
+		job = pool->job[pool->head];
+		pool->head = (pool->head + 1) % PREFETCH_QUEUE_LEN;
+		--pool->njobs;
+		mutex_unlock(&pool->mutex);
+
+		run_job(ctx, &job);
+
+		mutex_lock(&pool->mutex);
+	}
+	if (ctx)
+		free_private_ctx(ctx);
+	--pool->nrunning;
+	cond_broadcast(&pool->idle);
+	mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+/**  Allocate a prefetch worker pool.
+ * @param ctx  Dump file object.
+ * @returns    Error status.
+ */
+static kdump_status
+alloc_pool(kdump_ctx_t *ctx)
+{
+	struct prefetch_pool *pool;
+
+	pool = calloc(1, sizeof *pool);
+	if (!pool)
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot allocate prefetch pool");
+
+	if (mutex_init(&pool->mutex, NULL))
+		goto err_free;
+	if (cond_init(&pool->cond, NULL))
+		goto err_mutex;
+	if (cond_init(&pool->idle, NULL))
+		goto err_cond;
+
+	ctx->shared->prefetch = pool;
+	return KDUMP_OK;
+
+ err_cond:
+	cond_destroy(&pool->cond);
+ err_mutex:
+	mutex_destroy(&pool->mutex);
+ err_free:
+	free(pool);
+	return set_error(ctx, KDUMP_ERR_SYSTEM,
+			 "Cannot initialize prefetch pool");
+}
+
+/**  Set the number of prefetch worker threads.
+ * @param ctx  Dump file object (write-locked).
+ * @param n    Requested number of threads.
+ * @returns    Error status.
+ *
+ * Surplus workers exit after finishing their current job.
+ */
+kdump_status
+prefetch_set_threads(kdump_ctx_t *ctx, unsigned n)
+{
+	struct kdump_shared *shared = ctx->shared;
+	struct prefetch_pool *pool;
+	thread_t tid;
+	int err = 0;
+	kdump_status status;
+
+	if (!shared->prefetch) {
+		if (!n)
+			return KDUMP_OK;
+		status = alloc_pool(ctx);
+		if (status != KDUMP_OK)
+			return status;
+	}
+	pool = shared->prefetch;
+
+	mutex_lock(&pool->mutex);
+	pool->nthreads = n;
+	while (pool->nrunning < n) {
+		err = thread_create(&tid, prefetch_worker, shared);
+		if (err) {
+			pool->nthreads = pool->nrunning;
+			break;
+		}
+		thread_detach(tid);
+		++pool->nrunning;
+	}
+	if (!pool->nthreads)
+		pool->njobs = 0;
+	cond_broadcast(&pool->cond);
+	mutex_unlock(&pool->mutex);
+
+	if (err)
+		return set_error(ctx, (err == ENOSYS
+				       ? KDUMP_ERR_NOTIMPL
+				       : KDUMP_ERR_SYSTEM),
+				 "Cannot start prefetch thread: %s",
+				 strerror(err));
+	return KDUMP_OK;
+}
+
+/**  Queue a prefetch request.
+ * @param ctx   Dump file object (locked).
+ * @param addr  Address of the first page.
+ * @param n     Number of pages.
+ * @param fn    Read function, or @c NULL to use the @c get_page method.
+ * @returns     @c true if the request was handled by the pool,
+ *              @c false if there are no prefetch workers.
+ *
+ * If the queue is full, the request is silently dropped, because
+ * prefetching is merely a hint.
+ *
+ * Pages are loaded into the page cache partition of @p ctx, regardless
+ * of the NUMA node which runs the worker.
+ */
+bool
+prefetch_submit(kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr,
+		unsigned n, read_page_fn *fn)
+{
+	struct kdump_shared *shared = ctx->shared;
+	struct prefetch_pool *pool = shared->prefetch;
+	struct prefetch_job *job;
+
+	if (!pool)
+		return false;
+
+	mutex_lock(&pool->mutex);
+	if (!pool->nthreads) {
+		mutex_unlock(&pool->mutex);
+		return false;
+	}
+
+	if (pool->njobs < PREFETCH_QUEUE_LEN) {
+		job = &pool->job[(pool->head + pool->njobs) %
+				 PREFETCH_QUEUE_LEN];
+		job->addr = *addr;
+		job->n = n;
+		job->fn = fn;
+		job->node = cache_node(ctx);
+		job->ops = shared->ops;
+		++pool->njobs;
+		cond_signal(&pool->cond);
+	}
+	mutex_unlock(&pool->mutex);
+
+	return true;
+}
+
+/**  Stop all prefetch workers and free the pool.
+ * @param shared  Shared data of a dump file object (unlocked).
+ *
+ * The shared data must not be locked by the caller, because workers
+ * may need to acquire the lock to finish their current job.
+ */
+void
+prefetch_free(struct kdump_shared *shared)
+{
+	struct prefetch_pool *pool = shared->prefetch;
+
+	if (!pool)
+		return;
+
+	mutex_lock(&pool->mutex);
+	pool->nthreads = 0;
+	pool->njobs = 0;
+	cond_broadcast(&pool->cond);
+	while (pool->nrunning)
+		cond_wait(&pool->idle, &pool->mutex);
+	mutex_unlock(&pool->mutex);
+
+	cond_destroy(&pool->idle);
+	cond_destroy(&pool->cond);
+	mutex_destroy(&pool->mutex);
+	free(pool);
+	shared->prefetch = NULL;
+}
+
+static kdump_status
+prefetch_threads_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
+			  kdump_attr_value_t *val)
+{
+	if (val->number > PREFETCH_THREADS_MAX)
+		return set_error(ctx, KDUMP_ERR_INVALID,
+				 "Too many prefetch threads (max %u)",
+				 PREFETCH_THREADS_MAX);
+	return KDUMP_OK;
+}
+
+static kdump_status
+prefetch_threads_post_hook(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	return prefetch_set_threads(ctx, attr_value(attr)->number);
+}
+
+const struct attr_ops prefetch_threads_ops = {
+	.pre_set = prefetch_threads_pre_hook,
+	.post_set = prefetch_threads_post_hook,
+};
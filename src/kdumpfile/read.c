@@ -34,6 +34,272 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
+
+/** A batch of pages may hold at most this fraction of the cache
+ * (as a shift). */
+#define BATCH_CACHE_SHIFT	4
+
+/**  Get the page cache partition index of a dump file object.
+ * @param ctx  Dump file object.
+ * @returns    Index of the partition, or zero if the page cache is
+ *             not partitioned.
+ *
+ * Unless the object is bound to a partition, this is the partition
+ * of the NUMA node which runs the calling thread.
+ */
+unsigned
+cache_node(kdump_ctx_t *ctx)
+{
+	const struct numa_topology *numa = ctx->shared->numa;
+
+	if (!numa)
+		return 0;
+	if (ctx->numa_node >= 0 && (unsigned)ctx->numa_node < numa->nnodes)
+		return ctx->numa_node;
+	return numa_local_node(numa);
+}
+
+/**  Get the page cache partition of a dump file object.
+ * @param ctx  Dump file object.
+ * @returns    Page cache partition (see @ref cache_node).
+ */
+static inline struct cache *
+local_cache(kdump_ctx_t *ctx)
+{
+	return ctx->shared->node_cache
+		? ctx->shared->node_cache[cache_node(ctx)]
+		: ctx->shared->cache;
+}
+
+/**  Find a page in the cache partitions of other NUMA nodes.
+ * @param      ctx     Dump file object.
+ * @param      local   Partition which has been searched already.
+ * @param      key     Cache key.
+ * @param[out] pcache  Partition of the returned entry.
+ * @returns            A valid cache entry, or @c NULL if not found.
+ */
+static struct cache_entry *
+find_remote(kdump_ctx_t *ctx, const struct cache *local, cache_key_t key,
+	    struct cache **pcache)
+{
+	struct kdump_shared *shared = ctx->shared;
+	struct cache_entry *entry;
+	unsigned i;
+
+	if (!shared->node_cache)
+		return NULL;
+
+	for (i = 0; i < shared->numa->nnodes; ++i) {
+		if (shared->node_cache[i] == local)
+			continue;
+		entry = cache_find_entry(shared->node_cache[i], key);
+		if (entry) {
+			*pcache = shared->node_cache[i];
+			++ctx->remote_hits;
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/**  Use a page from another partition instead of loading it.
+ * @param ctx  Dump file object.
+ * @param pio  Page I/O control with a local entry which is not valid.
+ * @returns    @c true if the page was found in another partition.
+ *
+ * If the page is found, the local entry is discarded, and @p pio is
+ * changed to refer to the remote entry.
+ */
+static bool
+use_remote_page(kdump_ctx_t *ctx, struct page_io *pio)
+{
+	struct fcache_entry *fce = pio->chunk.embed_fces;
+	struct cache_entry *entry;
+	struct cache *cache;
+
+	entry = find_remote(ctx, fce->cache, fce->ce->key, &cache);
+	if (!entry)
+		return false;
+
+	cache_discard(fce->cache, fce->ce);
+	fce->cache = cache;
+	fce->ce = entry;
+	pio->chunk.data = entry->data;
+	return true;
+}
+
+/**  Read pages ahead into the default cache.
+ *
+ * @param ctx   Dump file object.
+ * @param addr  Full address of the first page.
+ * @param n     Number of pages.
+ * @param fn    Read function.
+ *
+ * Pages which are already cached or being loaded are skipped, and so
+ * are pages which have no free slot in the cache. Reading ahead stops
+ * at the first page which cannot be read. Errors are not reported,
+ * because nobody has asked for these pages yet.
+ */
+void
+cache_read_ahead(kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr,
+		 unsigned n, read_page_fn *fn)
+{
+	struct cache *cache = local_cache(ctx);
+	struct cache_entry *entry;
+	struct page_io pio;
+	kdump_status ret;
+
+	pio.addr = *addr;
+	pio.chunk.nent = 1;
+	pio.chunk.embed_fces->cache = cache;
+	for ( ; n; --n, pio.addr.addr += get_page_size(ctx)) {
+		entry = cache_get_readahead(cache,
+					    pio.addr.addr | pio.addr.as);
+		if (!entry)
+			continue;
+
+		pio.chunk.data = entry->data;
+		pio.chunk.embed_fces->ce = entry;
+		ret = fn(ctx, &pio);
+		if (ret != KDUMP_OK) {
+			cache_discard(cache, entry);
+			clear_error(ctx);
+			break;
+		}
+		cache_insert(cache, entry);
+		cache_put_entry(cache, entry);
+	}
+}
+
+/**  Let the file format start reading pages in the background.
+ *
+ * @param ctx   Dump file object.
+ * @param addr  Full address of the first page.
+ * @param n     Number of pages.
+ */
+static void
+file_read_ahead(kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr,
+		unsigned n)
+{
+	if (ctx->shared->ops->read_ahead)
+		ctx->shared->ops->read_ahead(ctx, addr, n);
+}
+
+/**  Keep the read-ahead window in front of a sequential reader.
+ *
+ * @param ctx   Dump file object.
+ * @param addr  Full address of the page that has just been read.
+ * @param fn    Read function.
+ *
+ * Pages are read ahead in batches of at least half the window, so
+ * that the reader does not trigger a read-ahead for every page. If
+ * there is a prefetch worker pool, the batch is handed over to it;
+ * otherwise, it is read synchronously.
+ */
+static void
+follow_stream(kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr,
+	      read_page_fn *fn)
+{
+	unsigned window = get_cache_readahead(ctx);
+	size_t pgsz = get_page_size(ctx);
+	addrxlat_fulladdr_t start;
+	kdump_addr_t end;
+	unsigned n;
+
+	if (!ctx->ra.run || !window || ctx->ra.disabled)
+		return;
+
+	end = addr->addr + (kdump_addr_t)(window + 1) * pgsz;
+	if (ctx->ra.ahead <= addr->addr)
+		ctx->ra.ahead = addr->addr + pgsz;
+	if (ctx->ra.ahead >= end)
+		return;
+	n = (end - ctx->ra.ahead) / pgsz;
+	if (n < (window + 1) / 2)
+		return;
+
+	start.addr = ctx->ra.ahead;
+	start.as = addr->as;
+	ctx->ra.ahead = end;
+	fcache_note_access(ctx->shared->fcache, true);
+	file_read_ahead(ctx, &start, n);
+	if (!prefetch_submit(ctx, &start, n, fn))
+		cache_read_ahead(ctx, &start, n, fn);
+}
+
+/**  Get a page without adding it to the default cache.
+ *
+ * @param ctx  Dump file object.
+ * @param pio  Page I/O control.
+ * @param fn   Read function.
+ * @returns    Error status.
+ *
+ * If the page is cached, it is used, but it is not moved within the
+ * cache. Otherwise, it is read into a newly allocated buffer, which
+ * is freed when the page is put back.
+ */
+static kdump_status
+scan_get_page(kdump_ctx_t *ctx, struct page_io *pio, read_page_fn *fn)
+{
+	struct cache *cache = local_cache(ctx);
+	struct cache_entry *entry;
+	cache_key_t key;
+	kdump_status ret;
+
+	key = pio->addr.addr | pio->addr.as;
+	entry = cache_peek_entry(cache, key);
+	if (!entry)
+		entry = find_remote(ctx, cache, key, &cache);
+	if (entry) {
+		pio->chunk.nent = 1;
+		pio->chunk.embed_fces->cache = cache;
+		pio->chunk.embed_fces->ce = entry;
+		pio->chunk.data = entry->data;
+		return KDUMP_OK;
+	}
+
+	fcache_note_access(ctx->shared->fcache, true);
+	pio->chunk.nent = 0;
+	pio->chunk.fc = NULL;
+	pio->chunk.data = malloc(get_page_size(ctx));
+	if (!pio->chunk.data)
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot allocate page buffer");
+	ret = fn(ctx, pio);
+	if (ret != KDUMP_OK)
+		free(pio->chunk.data);
+	return ret;
+}
+
+/**  Update the sequential read detector.
+ * @param ctx  Dump file object.
+ * @param key  Cache key of the page which is being read.
+ */
+static inline void
+track_stream(kdump_ctx_t *ctx, cache_key_t key)
+{
+	if (key == ctx->ra.next)
+		++ctx->ra.run;
+	else {
+		ctx->ra.run = 0;
+		ctx->ra.ahead = 0;
+	}
+	ctx->ra.next = key + get_page_size(ctx);
+}
+
+/**  Report a cache miss to the access pattern detector.
+ * @param ctx  Dump file object.
+ *
+ * Misses within a sequential run are not reported, because they are
+ * already covered by reading ahead (see @ref follow_stream).
+ */
+static inline void
+note_miss(kdump_ctx_t *ctx)
+{
+	if (!ctx->ra.run)
+		fcache_note_access(ctx->shared->fcache, false);
+}
 
 /** Get a page from the default cache.
  *
@@ -44,36 +310,57 @@
  *
  * If the page is not currently found in the cache, read it using
  * the read function.
+ *
+ * If the page cache is partitioned, the partition of the current NUMA
+ * node is searched first. If the page is not found there, but another
+ * partition has it, the page from that partition is used. Otherwise,
+ * the page is read into the local partition.
+ *
+ * If the page follows the previous page read through this context,
+ * up to "cache.readahead" subsequent pages are also read into the
+ * cache.
+ *
+ * If @ref KDUMP_READ_SCAN is set for the context, pages are not added
+ * to the cache (see @ref scan_get_page).
  */
 kdump_status
 cache_get_page(kdump_ctx_t *ctx, struct page_io *pio, read_page_fn *fn)
 {
 	struct cache_entry *entry;
+	cache_key_t key;
 	kdump_status ret;
 
-	mutex_lock(&ctx->shared->cache_lock);
+	if (ctx->read_flags & KDUMP_READ_SCAN)
+		return scan_get_page(ctx, pio, fn);
+
+	key = pio->addr.addr | pio->addr.as;
+	track_stream(ctx, key);
+
 	pio->chunk.nent = 1;
-	pio->chunk.embed_fces->cache = ctx->shared->cache;
-	entry = cache_get_entry(pio->chunk.embed_fces->cache,
-				pio->addr.addr | pio->addr.as);
-	mutex_unlock(&ctx->shared->cache_lock);
+	pio->chunk.embed_fces->cache = local_cache(ctx);
+	if (ctx->nowait)
+		cache_get_entries(pio->chunk.embed_fces->cache,
+				  &key, &entry, 1);
+	else
+		entry = cache_get_entry(pio->chunk.embed_fces->cache, key);
 	if (!entry)
 		return set_error(ctx, KDUMP_ERR_BUSY,
 				 "Cache is fully utilized");
 
 	pio->chunk.data = entry->data;
 	pio->chunk.embed_fces->ce = entry;
-	if (cache_entry_valid(entry))
-		return KDUMP_OK;
-
-	ret = fn(ctx, pio);
-	mutex_lock(&ctx->shared->cache_lock);
-	if (ret == KDUMP_OK)
+	if (!cache_entry_valid(entry) && !use_remote_page(ctx, pio)) {
+		note_miss(ctx);
+		ret = fn(ctx, pio);
+		if (ret != KDUMP_OK) {
+			cache_discard(pio->chunk.embed_fces->cache, entry);
+			return ret;
+		}
 		cache_insert(pio->chunk.embed_fces->cache, entry);
-	else
-		cache_discard(pio->chunk.embed_fces->cache, entry);
-	mutex_unlock(&ctx->shared->cache_lock);
-	return ret;
+	}
+
+	follow_stream(ctx, &pio->addr, fn);
+	return KDUMP_OK;
 }
 
 /**  Drop a reference to an I/O page from the default cache.
@@ -86,6 +373,106 @@ cache_put_page(kdump_ctx_t *ctx, struct page_io *pio)
 	fcache_put_chunk(&pio->chunk);
 }
 
+/** Get multiple pages from the default cache.
+ *
+ * @param         ctx  Dump file object.
+ * @param         pio  Page I/O controls (with translated addresses).
+ * @param[in,out] pn   Number of pages (at most @ref CACHE_BATCH_MAX)
+ *                     on input, number of pages got on output.
+ * @param         fn   Read function.
+ * @returns            Error status.
+ *
+ * This function works like calling @ref cache_get_page for each page,
+ * but cache entries are got, inserted and released in batches, so each
+ * cache shard is locked only a few times.
+ *
+ * Pages are got in order. If a page cannot be got without waiting
+ * (e.g. because another thread is loading it), this function stops
+ * there and returns @ref KDUMP_OK; the caller should get that page with
+ * @ref cache_get_page. The same happens for the first page if
+ * @ref KDUMP_READ_SCAN is set. On error, @p pn is set to the index of
+ * the page which failed.
+ *
+ * Pages got with this function must be released with
+ * @ref cache_put_pages.
+ */
+kdump_status
+cache_get_pages(kdump_ctx_t *ctx, struct page_io *pio, unsigned *pn,
+		read_page_fn *fn)
+{
+	struct cache *cache = local_cache(ctx);
+	struct cache_entry *entries[CACHE_BATCH_MAX];
+	struct cache_entry *loaded[CACHE_BATCH_MAX];
+	cache_key_t keys[CACHE_BATCH_MAX];
+	unsigned i, n = *pn;
+	kdump_status ret;
+
+	if (ctx->read_flags & KDUMP_READ_SCAN) {
+		*pn = 0;
+		return KDUMP_OK;
+	}
+
+	for (i = 0; i < n; ++i)
+		keys[i] = pio[i].addr.addr | pio[i].addr.as;
+	cache_get_entries(cache, keys, entries, n);
+
+	ret = KDUMP_OK;
+	for (i = 0; i < n && entries[i]; ++i) {
+		pio[i].chunk.nent = 1;
+		pio[i].chunk.embed_fces->cache = cache;
+		pio[i].chunk.embed_fces->ce = entries[i];
+		pio[i].chunk.data = entries[i]->data;
+		loaded[i] = NULL;
+		if (!cache_entry_valid(entries[i]) &&
+		    !use_remote_page(ctx, &pio[i])) {
+			ret = fn(ctx, &pio[i]);
+			if (ret != KDUMP_OK)
+				break;
+			loaded[i] = entries[i];
+		}
+		track_stream(ctx, keys[i]);
+		if (loaded[i])
+			note_miss(ctx);
+	}
+	*pn = i;
+	cache_insert_entries(cache, loaded, i);
+
+	/* Give back the entries which are not used. */
+	for ( ; i < n; ++i) {
+		if (!entries[i])
+			continue;
+		if (cache_entry_valid(entries[i]))
+			cache_put_entry(cache, entries[i]);
+		else
+			cache_discard(cache, entries[i]);
+	}
+
+	if (*pn)
+		follow_stream(ctx, &pio[*pn - 1].addr, fn);
+	return ret;
+}
+
+/**  Drop references to pages got with @ref cache_get_pages.
+ * @param ctx  Dump file object.
+ * @param pio  Page I/O controls.
+ * @param n    Number of pages.
+ */
+void
+cache_put_pages(kdump_ctx_t *ctx, struct page_io *pio, unsigned n)
+{
+	struct cache *cache = local_cache(ctx);
+	struct cache_entry *entries[CACHE_BATCH_MAX];
+	unsigned i, nent;
+
+	/* Pages from other partitions are released one by one. */
+	for (i = nent = 0; i < n; ++i)
+		if (pio[i].chunk.embed_fces->cache == cache)
+			entries[nent++] = pio[i].chunk.embed_fces->ce;
+		else
+			cache_put_page(ctx, &pio[i]);
+	cache_put_entries(cache, entries, nent);
+}
+
 static addrxlat_status
 xlat_pio_op(void *data, const addrxlat_fulladdr_t *addr)
 {
@@ -94,16 +481,16 @@ xlat_pio_op(void *data, const addrxlat_fulladdr_t *addr)
 	return ADDRXLAT_OK;
 }
 
-/**  Get page with address tranlation.
+/**  Translate a page I/O address.
  * @param ctx  Dump file object.
  * @param pio  Page I/O control.
+ * @returns    Error status.
  *
  * This function translates the page I/O address to an address space that
- * is included in @c xlat_caps. The resulting page I/O is then passed to
- * a @c get_page method.
+ * is included in @c xlat_caps.
  */
-kdump_status
-get_page_xlat(kdump_ctx_t *ctx, struct page_io *pio)
+static kdump_status
+xlat_page_io(kdump_ctx_t *ctx, struct page_io *pio)
 {
 	addrxlat_op_ctl_t ctl;
 	kdump_status status;
@@ -124,6 +511,26 @@ get_page_xlat(kdump_ctx_t *ctx, struct page_io *pio)
 		return set_error(ctx, addrxlat2kdump(ctx, xlaterr),
 				 "Cannot get page I/O address");
 
+	return KDUMP_OK;
+}
+
+/**  Get page with address tranlation.
+ * @param ctx  Dump file object.
+ * @param pio  Page I/O control.
+ *
+ * This function translates the page I/O address to an address space that
+ * is included in @c xlat_caps. The resulting page I/O is then passed to
+ * a @c get_page method.
+ */
+kdump_status
+get_page_xlat(kdump_ctx_t *ctx, struct page_io *pio)
+{
+	kdump_status status;
+
+	status = xlat_page_io(ctx, pio);
+	if (status != KDUMP_OK)
+		return status;
+
 	return ctx->shared->ops->get_page(ctx, pio);
 }
 
@@ -139,6 +546,294 @@ get_page(kdump_ctx_t *ctx, struct page_io *pio)
 		: get_page_xlat(ctx, pio);
 }
 
+/**  Free the private page cache.
+ * @param l1  Private page cache.
+ */
+static void
+l1_free_data(struct l1_cache *l1)
+{
+	free(l1->key);
+	free(l1->data);
+	free(l1->ghost);
+	l1->key = NULL;
+	l1->data = NULL;
+	l1->ghost = NULL;
+	l1->n = 0;
+}
+
+/**  Free the private page cache of a dump file object.
+ * @param ctx  Dump file object (shared data locked for writing).
+ *
+ * The statistics are kept in the shared data, so they are not lost.
+ */
+void
+l1_free(kdump_ctx_t *ctx)
+{
+	ctx->shared->l1_hits += ctx->l1.hits;
+	ctx->shared->l1_misses += ctx->l1.misses;
+	l1_free_data(&ctx->l1);
+}
+
+/**  Drop all pages from the private page caches.
+ * @param shared  Dump file shared data (locked for writing).
+ *
+ * This function must be called when the cached data may no longer be
+ * valid, e.g. when another file is opened or the page cache is
+ * re-allocated.
+ */
+void
+l1_flush(struct kdump_shared *shared)
+{
+	kdump_ctx_t *cur;
+	unsigned i;
+
+	list_for_each_entry(cur, &shared->ctx, list)
+		for (i = 0; i < cur->l1.n; ++i)
+			cur->l1.key[i] = cur->l1.ghost[i] = ADDRXLAT_NOADDR;
+}
+
+/**  Make sure the private page cache has the configured size.
+ * @param ctx  Dump file object.
+ *
+ * If the number of slots or the page size has changed, all pages are
+ * dropped. If memory cannot be allocated, the private cache is simply
+ * disabled. It is also disabled for live data, because the copies
+ * would never be updated.
+ */
+static void
+l1_resize(kdump_ctx_t *ctx)
+{
+	struct l1_cache *l1 = &ctx->l1;
+	unsigned i, n = get_cache_l1_pages(ctx);
+	size_t size = get_page_size(ctx);
+
+	if (ctx->shared->ops && ctx->shared->ops->live)
+		n = 0;
+
+	if (l1->n == n && l1->size == size)
+		return;
+
+	l1_free_data(l1);
+	l1->size = size;
+	l1->shift = get_page_shift(ctx);
+	if (!n)
+		return;
+
+	l1->key = malloc(n * sizeof(*l1->key));
+	l1->ghost = malloc(n * sizeof(*l1->ghost));
+	l1->data = malloc(n * size);
+	if (!l1->key || !l1->ghost || !l1->data) {
+		l1_free_data(l1);
+		return;
+	}
+	for (i = 0; i < n; ++i)
+		l1->key[i] = l1->ghost[i] = ADDRXLAT_NOADDR;
+	l1->n = n;
+}
+
+/**  Get the private cache slot for a page.
+ * @param l1   Private page cache (non-empty).
+ * @param key  Page address combined with its address space.
+ * @returns    Slot index.
+ */
+static inline unsigned
+l1_slot(const struct l1_cache *l1, kdump_addr_t key)
+{
+	uint32_t hash = ((key >> l1->shift) * 0x9e3779b97f4a7c15ULL) >> 32;
+	return ((uint64_t)hash * l1->n) >> 32;
+}
+
+/**  Read part of a page.
+ * @param ctx     Dump file object.
+ * @param pio     Page I/O control.
+ * @param off     Offset within the page.
+ * @param buffer  Buffer to receive data.
+ * @param len     Number of bytes to read.
+ * @returns       Error status.
+ *
+ * The private page cache is searched after address translation, so
+ * its contents do not depend on the translation.
+ *
+ * Copying a page is much more expensive than reading a few bytes from
+ * it, so a missed page replaces the page in its slot only if it was
+ * also the last page missed in that slot. Pages which are read as a
+ * whole are not added at all, because they are usually not read again
+ * soon.
+ */
+static kdump_status
+read_page_part(kdump_ctx_t *ctx, struct page_io *pio, size_t off,
+	       void *buffer, size_t len)
+{
+	struct l1_cache *l1 = &ctx->l1;
+	unsigned char *data;
+	kdump_addr_t key;
+	unsigned slot;
+	kdump_status ret;
+
+	if (!l1->n) {
+		ret = get_page(ctx, pio);
+		if (ret != KDUMP_OK)
+			return ret;
+		memcpy(buffer, pio->chunk.data + off, len);
+		put_page(ctx, pio);
+		return KDUMP_OK;
+	}
+
+	if (!(ctx->xlat->xlat_caps & ADDRXLAT_CAPS(pio->addr.as))) {
+		ret = xlat_page_io(ctx, pio);
+		if (ret != KDUMP_OK)
+			return ret;
+	}
+
+	key = pio->addr.addr | pio->addr.as;
+	slot = l1_slot(l1, key);
+	data = l1->data + slot * l1->size;
+	if (l1->key[slot] == key) {
+		++l1->hits;
+		memcpy(buffer, data + off, len);
+		return KDUMP_OK;
+	}
+	++l1->misses;
+
+	ret = ctx->shared->ops->get_page(ctx, pio);
+	if (ret != KDUMP_OK)
+		return ret;
+	memcpy(buffer, pio->chunk.data + off, len);
+	if (len == l1->size)
+		;		/* read as a whole */
+	else if (l1->ghost[slot] != key)
+		l1->ghost[slot] = key;
+	else {
+		l1->key[slot] = key;
+		memcpy(data, pio->chunk.data, l1->size);
+	}
+	put_page(ctx, pio);
+	return KDUMP_OK;
+}
+
+static kdump_status
+l1_stats_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	unsigned long hits = ctx->shared->l1_hits;
+	unsigned long misses = ctx->shared->l1_misses;
+	kdump_ctx_t *cur;
+
+	list_for_each_entry(cur, &ctx->shared->ctx, list) {
+		hits += cur->l1.hits;
+		misses += cur->l1.misses;
+	}
+	ctx->shared->l1_cache_hits.number = hits;
+	ctx->shared->l1_cache_misses.number = misses;
+	return KDUMP_OK;
+}
+
+/**  Statistics of the private page cache.
+ * The values are summed up over all dump file objects which share
+ * the same dump file, including those which have been freed.
+ */
+const struct attr_ops l1_cache_stats_ops = {
+	.revalidate = l1_stats_revalidate,
+};
+
+static kdump_status
+numa_stats_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	unsigned long hits = ctx->shared->remote_hits;
+	kdump_ctx_t *cur;
+
+	list_for_each_entry(cur, &ctx->shared->ctx, list)
+		hits += cur->remote_hits;
+	ctx->shared->numa_remote_hits.number = hits;
+	return KDUMP_OK;
+}
+
+/**  Statistics of page cache partitions.
+ * The values are summed up over all dump file objects which share
+ * the same dump file, including those which have been freed.
+ */
+const struct attr_ops numa_stats_ops = {
+	.revalidate = numa_stats_revalidate,
+};
+
+static kdump_status
+l1_pages_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
+		  kdump_attr_value_t *val)
+{
+	if (val->number > MAX_L1_PAGES)
+		return set_error(ctx, KDUMP_ERR_INVALID,
+				 "Private cache too big (max %u pages)",
+				 MAX_L1_PAGES);
+	return KDUMP_OK;
+}
+
+const struct attr_ops l1_pages_ops = {
+	.pre_set = l1_pages_pre_hook,
+};
+
+/**  Read whole pages in a batch.
+ * @param      ctx     Dump file object.
+ * @param      as      Address space of @p addr.
+ * @param      addr    Start address.
+ * @param      buffer  Buffer to receive data.
+ * @param      remain  Number of bytes to read.
+ * @param[out] pret    Error status.
+ * @returns            Number of bytes read.
+ *
+ * This function reads up to @ref CACHE_BATCH_MAX pages with
+ * @ref cache_get_pages. It may read fewer bytes than requested even if
+ * there is no error; the caller should read the next page on its own.
+ *
+ * A batch holds all its pages until the data is copied, so its size is
+ * also limited by @ref BATCH_CACHE_SHIFT. Otherwise, a few threads
+ * reading in batches could fill up a small cache.
+ */
+static size_t
+read_batch(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
+	   unsigned char *buffer, size_t remain, kdump_status *pret)
+{
+	struct page_io pio[CACHE_BATCH_MAX];
+	size_t pgsz = get_page_size(ctx);
+	size_t off, partlen, done;
+	unsigned i, n;
+
+	off = addr % pgsz;
+	n = (off + remain - 1) / pgsz + 1;
+	if (n > CACHE_BATCH_MAX)
+		n = CACHE_BATCH_MAX;
+	if (n > get_cache_size(ctx) >> BATCH_CACHE_SHIFT)
+		n = get_cache_size(ctx) >> BATCH_CACHE_SHIFT;
+	if (n < 2) {
+		*pret = KDUMP_OK;
+		return 0;
+	}
+
+	for (i = 0; i < n; ++i) {
+		pio[i].addr.as = as;
+		pio[i].addr.addr = page_align(ctx, addr) + i * pgsz;
+		if (!(ctx->xlat->xlat_caps & ADDRXLAT_CAPS(as)) &&
+		    xlat_page_io(ctx, &pio[i]) != KDUMP_OK) {
+			/* Let the caller report the error. */
+			clear_error(ctx);
+			break;
+		}
+	}
+	n = i;
+
+	*pret = cache_get_pages(ctx, pio, &n, ctx->shared->ops->read_page);
+
+	done = 0;
+	for (i = 0; i < n; ++i) {
+		partlen = pgsz - off;
+		if (partlen > remain - done)
+			partlen = remain - done;
+		memcpy(buffer + done, pio[i].chunk.data + off, partlen);
+		done += partlen;
+		off = 0;
+	}
+	cache_put_pages(ctx, pio, n);
+	return done;
+}
+
 /**  Internal version of @ref kdump_read
  * @param         ctx      Dump file object.
  * @param[in]     as       Address space of @p addr.
@@ -150,6 +845,10 @@ get_page(kdump_ctx_t *ctx, struct page_io *pio)
  * Use this function internally if the shared lock is already held
  * (for reading or writing).
  *
+ * If the read spans multiple pages, and the format reads all pages
+ * through the default cache, pages are got in batches (see
+ * @ref read_batch).
+ *
  * @sa kdump_read
  */
 kdump_status
@@ -160,23 +859,36 @@ read_locked(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
 	size_t remain;
 	kdump_status ret;
 
+	l1_resize(ctx);
+
 	ret = KDUMP_OK;
 	remain = *plength;
 	while (remain) {
 		size_t off, partlen;
 
+		off = addr % get_page_size(ctx);
+		partlen = get_page_size(ctx) - off;
+		if (partlen > remain)
+			partlen = remain;
+
+		if (partlen < remain && ctx->shared->ops->read_page) {
+			size_t done = read_batch(ctx, as, addr, buffer,
+						 remain, &ret);
+			addr += done;
+			buffer += done;
+			remain -= done;
+			if (ret != KDUMP_OK)
+				break;
+			if (done)
+				continue;
+		}
+
 		pio.addr.as = as;
 		pio.addr.addr = page_align(ctx, addr);
-		ret = get_page(ctx, &pio);
+		ret = read_page_part(ctx, &pio, off, buffer, partlen);
 		if (ret != KDUMP_OK)
 			break;
 
-		off = addr % get_page_size(ctx);
-		partlen = get_page_size(ctx) - off;
-		if (partlen > remain)
-			partlen = remain;
-		memcpy(buffer, pio.chunk.data + off, partlen);
-		put_page(ctx, &pio);
 		addr += partlen;
 		buffer += partlen;
 		remain -= partlen;
@@ -199,6 +911,168 @@ kdump_read(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
 	return ret;
 }
 
+void
+kdump_set_read_flags(kdump_ctx_t *ctx, unsigned long flags)
+{
+	ctx->read_flags = flags;
+}
+
+/**  Load a page into the caches.
+ * @param ctx  Dump file object.
+ * @param pio  Page I/O control with a translated address.
+ *
+ * Errors are ignored; a page which cannot be read is simply not cached.
+ */
+static void
+warm_page(kdump_ctx_t *ctx, struct page_io *pio)
+{
+	if (ctx->shared->ops->get_page(ctx, pio) == KDUMP_OK)
+		put_page(ctx, pio);
+	else
+		clear_error(ctx);
+}
+
+/**  Load consecutive pages into the caches.
+ * @param ctx   Dump file object.
+ * @param addr  Translated address of the first page.
+ * @param n     Number of pages.
+ *
+ * The address space of @p addr must be included in @c xlat_caps.
+ * Pages which are being loaded by another thread, or which have no
+ * free cache slot, are skipped without waiting.
+ */
+void
+prefetch_pages(kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr, unsigned n)
+{
+	struct page_io pio;
+	bool nowait;
+
+	nowait = ctx->nowait;
+	ctx->nowait = true;
+	pio.addr = *addr;
+	for ( ; n; --n, pio.addr.addr += get_page_size(ctx))
+		warm_page(ctx, &pio);
+	ctx->nowait = nowait;
+}
+
+/**  Hand consecutive pages over to prefetch threads.
+ * @param ctx   Dump file object.
+ * @param addr  Translated address of the first page.
+ * @param n     Number of pages.
+ *
+ * If there are no prefetch threads, the pages are loaded synchronously.
+ */
+static void
+submit_pages(kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr, unsigned n)
+{
+	if (!n)
+		return;
+	file_read_ahead(ctx, addr, n);
+	if (!prefetch_submit(ctx, addr, n, NULL))
+		prefetch_pages(ctx, addr, n);
+}
+
+/**  Prefetch one address range.
+ * @param ctx    Dump file object.
+ * @param as     Address space of @p addr.
+ * @param addr   Start address.
+ * @param len    Length of the range in bytes.
+ * @param async  Use prefetch threads if possible.
+ *
+ * Translated pages which are adjacent in the dump are grouped, so they
+ * can be handed over to prefetch threads as one request. Pages in the
+ * kernel virtual address space need the address translation of @p ctx
+ * to be read, so they are always loaded synchronously.
+ */
+static void
+prefetch_range(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
+	       size_t len, bool async)
+{
+	size_t pgsz = get_page_size(ctx);
+	addrxlat_fulladdr_t first;
+	struct page_io pio;
+	kdump_addr_t npages;
+	unsigned n = 0;
+
+	if (!len)
+		return;
+	npages = (addr % pgsz + len - 1) / pgsz + 1;
+	addr = page_align(ctx, addr);
+	for ( ; npages; --npages, addr += pgsz) {
+		pio.addr.as = as;
+		pio.addr.addr = addr;
+		if (!(ctx->xlat->xlat_caps & ADDRXLAT_CAPS(as)) &&
+		    xlat_page_io(ctx, &pio) != KDUMP_OK) {
+			clear_error(ctx);
+			continue;
+		}
+
+		if (!async || pio.addr.as == ADDRXLAT_KVADDR) {
+			warm_page(ctx, &pio);
+			continue;
+		}
+
+		if (n && n < UINT_MAX && pio.addr.as == first.as &&
+		    pio.addr.addr == first.addr + (kdump_addr_t)n * pgsz) {
+			++n;
+			continue;
+		}
+		submit_pages(ctx, &first, n);
+		first = pio.addr;
+		n = 1;
+	}
+	submit_pages(ctx, &first, n);
+}
+
+kdump_status
+kdump_prefetchv(kdump_ctx_t *ctx, const kdump_range_t *ranges, size_t n,
+		unsigned long flags)
+{
+	struct readahead ra;
+	unsigned long read_flags;
+	kdump_status ret;
+
+	clear_error(ctx);
+	rwlock_rdlock(&ctx->shared->lock);
+
+	if (!ctx->shared->ops) {
+		ret = set_error(ctx, KDUMP_ERR_INVALID,
+				"File format not initialized");
+		goto out;
+	}
+
+	ra = ctx->ra;
+	ctx->ra.disabled = true;
+	read_flags = ctx->read_flags;
+	ctx->read_flags = 0;
+	ctx->nowait = true;
+	while (n--) {
+		prefetch_range(ctx, ranges->as, ranges->addr, ranges->len,
+			       flags & KDUMP_PREFETCH_ASYNC);
+		++ranges;
+	}
+	ctx->nowait = false;
+	ctx->read_flags = read_flags;
+	ctx->ra = ra;
+	ret = KDUMP_OK;
+
+ out:
+	rwlock_unlock(&ctx->shared->lock);
+	return ret;
+}
+
+kdump_status
+kdump_prefetch(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
+	       size_t len, unsigned long flags)
+{
+	kdump_range_t range;
+
+	range.as = as;
+	range.addr = addr;
+	range.len = len;
+	return kdump_prefetchv(ctx, &range, 1, flags);
+}
+
 /**  Internal version of @ref kdump_read_string.
  * @param      ctx   Dump file object.
  * @param[in]  as    Address space of @c addr.
@@ -271,6 +1145,371 @@ kdump_read_string(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
 	return ret;
 }
 
+/**  Compare two read requests by address.
+ * @param a  Pointer to the first request pointer.
+ * @param b  Pointer to the second request pointer.
+ * @returns  Negative, zero or positive, like @c strcmp.
+ */
+static int
+iov_cmp(const void *a, const void *b)
+{
+	const kdump_iovec_t *x = *(const kdump_iovec_t *const *)a;
+	const kdump_iovec_t *y = *(const kdump_iovec_t *const *)b;
+
+	if (x->as != y->as)
+		return x->as < y->as ? -1 : 1;
+	if (x->addr != y->addr)
+		return x->addr < y->addr ? -1 : 1;
+	return 0;
+}
+
+kdump_status
+kdump_readv(kdump_ctx_t *ctx, kdump_iovec_t *iov, size_t n)
+{
+	kdump_iovec_t **order, *failed;
+	struct page_io pio;
+	bool held;
+	char *errmsg;
+	size_t i;
+
+	clear_error(ctx);
+
+	order = malloc(n * sizeof *order);
+	if (!order && n)
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot allocate %zu read requests", n);
+	for (i = 0; i < n; ++i)
+		order[i] = &iov[i];
+	qsort(order, n, sizeof *order, iov_cmp);
+
+	failed = NULL;
+	errmsg = NULL;
+	held = false;
+	rwlock_rdlock(&ctx->shared->lock);
+	for (i = 0; i < n; ++i) {
+		kdump_iovec_t *v = order[i];
+		kdump_addr_t addr = v->addr;
+		char *buffer = v->buf;
+		size_t remain = v->len;
+
+		v->status = KDUMP_OK;
+		while (remain) {
+			size_t off, partlen;
+
+			if (!held || pio.addr.as != v->as ||
+			    pio.addr.addr != page_align(ctx, addr)) {
+				if (held)
+					put_page(ctx, &pio);
+				pio.addr.as = v->as;
+				pio.addr.addr = page_align(ctx, addr);
+				v->status = get_page(ctx, &pio);
+				held = (v->status == KDUMP_OK);
+				if (!held)
+					break;
+				/* Translation may change the address. */
+				pio.addr.as = v->as;
+				pio.addr.addr = page_align(ctx, addr);
+			}
+
+			off = addr % get_page_size(ctx);
+			partlen = get_page_size(ctx) - off;
+			if (partlen > remain)
+				partlen = remain;
+			memcpy(buffer, pio.chunk.data + off, partlen);
+			addr += partlen;
+			buffer += partlen;
+			remain -= partlen;
+		}
+		v->len -= remain;
+
+		if (v->status != KDUMP_OK) {
+			if (!failed || v < failed) {
+				const char *msg = err_str(&ctx->err);
+				failed = v;
+				free(errmsg);
+				errmsg = msg ? strdup(msg) : NULL;
+			}
+			clear_error(ctx);
+		}
+	}
+	if (held)
+		put_page(ctx, &pio);
+	rwlock_unlock(&ctx->shared->lock);
+	free(order);
+
+	if (!failed)
+		return KDUMP_OK;
+	if (!errmsg)
+		return set_error(ctx, failed->status, "Read failed");
+	set_error(ctx, failed->status, "%s", errmsg);
+	free(errmsg);
+	return failed->status;
+}
+
+kdump_status
+kdump_get_page(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
+	       kdump_page_t **ppage)
+{
+	kdump_page_t *page;
+	kdump_status ret;
+
+	clear_error(ctx);
+
+	page = malloc(sizeof *page);
+	if (!page)
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot allocate page handle");
+
+	rwlock_rdlock(&ctx->shared->lock);
+	page->pio.addr.as = as;
+	page->pio.addr.addr = page_align(ctx, addr);
+	page->addr = page->pio.addr.addr;
+	ret = get_page(ctx, &page->pio);
+	rwlock_unlock(&ctx->shared->lock);
+
+	if (ret != KDUMP_OK) {
+		free(page);
+		return ret;
+	}
+
+	*ppage = page;
+	return KDUMP_OK;
+}
+
+const void *
+kdump_page_data(const kdump_page_t *page)
+{
+	return page->pio.chunk.data;
+}
+
+kdump_addr_t
+kdump_page_addr(const kdump_page_t *page)
+{
+	return page->addr;
+}
+
+void
+kdump_put_page(kdump_ctx_t *ctx, kdump_page_t *page)
+{
+	rwlock_rdlock(&ctx->shared->lock);
+	put_page(ctx, &page->pio);
+	rwlock_unlock(&ctx->shared->lock);
+	free(page);
+}
+
+/**  Find a page pinned by a dump file object.
+ * @param ctx   Dump file object.
+ * @param as    Address space of @p addr.
+ * @param addr  Page-aligned address.
+ * @returns     Pinned page, or @c NULL if not found.
+ */
+static struct pinned_page *
+find_pinned(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr)
+{
+	struct pinned_page *pp;
+
+	for (pp = ctx->pinned.page; pp < ctx->pinned.page + ctx->pinned.n;
+	     ++pp)
+		if (pp->as == as && pp->addr == addr)
+			return pp;
+	return NULL;
+}
+
+/**  Make room for one more pinned page.
+ * @param ctx  Dump file object.
+ * @returns    Pointer to the next unused element, or @c NULL on
+ *             allocation failure.
+ */
+static struct pinned_page *
+alloc_pinned(kdump_ctx_t *ctx)
+{
+	struct pinned_pages *pinned = &ctx->pinned;
+	struct pinned_page *page;
+	size_t alloc;
+
+	if (pinned->n < pinned->alloc)
+		return &pinned->page[pinned->n];
+
+	alloc = pinned->alloc ? 2 * pinned->alloc : 16;
+	page = realloc(pinned->page, alloc * sizeof(*page));
+	if (!page)
+		return NULL;
+	pinned->page = page;
+	pinned->alloc = alloc;
+	return &page[pinned->n];
+}
+
+/**  Release a pinned page.
+ * @param ctx  Dump file object (write-locked).
+ * @param pp   Pinned page.
+ */
+static void
+unpin_page(kdump_ctx_t *ctx, struct pinned_page *pp)
+{
+	put_page(ctx, &pp->pio);
+	ctx->shared->pinned_bytes.number -= get_page_size(ctx);
+}
+
+/**  Get the maximum number of pinned pages.
+ * @param ctx  Dump file object.
+ * @returns    Maximum number of pages pinned by all dump file objects.
+ *
+ * Half of the cache is left for other pages.
+ */
+static kdump_num_t
+max_pinned(kdump_ctx_t *ctx)
+{
+	return (ctx->shared->cache
+		? cache_capacity(ctx->shared->cache)
+		: get_cache_size(ctx)) / 2;
+}
+
+kdump_status
+kdump_pin_range(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
+		size_t len)
+{
+	struct pinned_page *pp;
+	struct readahead ra;
+	unsigned long read_flags;
+	kdump_addr_t npages;
+	kdump_num_t limit;
+	size_t pgsz, n;
+	kdump_status ret;
+
+	clear_error(ctx);
+	rwlock_wrlock(&ctx->shared->lock);
+
+	if (!ctx->shared->ops) {
+		ret = set_error(ctx, KDUMP_ERR_INVALID,
+				"File format not initialized");
+		goto out;
+	}
+	/* Other formats hold file cache chunks, which are much scarcer. */
+	if (!ctx->shared->ops->read_page) {
+		ret = set_error(ctx, KDUMP_ERR_NOTIMPL,
+				"Cannot pin pages in %s files",
+				ctx->shared->ops->name);
+		goto out;
+	}
+
+	ret = KDUMP_OK;
+	if (!len)
+		goto out;
+
+	pgsz = get_page_size(ctx);
+	limit = max_pinned(ctx);
+	npages = (addr % pgsz + len - 1) / pgsz + 1;
+	addr = page_align(ctx, addr);
+	n = ctx->pinned.n;
+	ra = ctx->ra;
+	ctx->ra.disabled = true;
+	read_flags = ctx->read_flags;
+	ctx->read_flags = 0;
+	/* Holders of the pages in a full cache cannot release them while
+	 * the write lock is held, so waiting for a free slot would never
+	 * end. */
+	ctx->nowait = true;
+	for ( ; npages; --npages, addr += pgsz) {
+		if (find_pinned(ctx, as, addr))
+			continue;
+
+		if (ctx->shared->pinned_bytes.number / pgsz >= limit) {
+			ret = set_error(ctx, KDUMP_ERR_BUSY,
+					"Too many pinned pages (max %llu)",
+					(unsigned long long) limit);
+			break;
+		}
+
+		pp = alloc_pinned(ctx);
+		if (!pp) {
+			ret = set_error(ctx, KDUMP_ERR_SYSTEM,
+					"Cannot allocate pinned page");
+			break;
+		}
+		pp->as = as;
+		pp->addr = addr;
+		pp->pio.addr.as = as;
+		pp->pio.addr.addr = addr;
+		ret = get_page(ctx, &pp->pio);
+		if (ret != KDUMP_OK)
+			break;
+		++ctx->pinned.n;
+		ctx->shared->pinned_bytes.number += pgsz;
+	}
+	ctx->nowait = false;
+	ctx->read_flags = read_flags;
+	ctx->ra = ra;
+
+	if (ret != KDUMP_OK)
+		while (ctx->pinned.n > n)
+			unpin_page(ctx, &ctx->pinned.page[--ctx->pinned.n]);
+
+ out:
+	rwlock_unlock(&ctx->shared->lock);
+	return ret;
+}
+
+kdump_status
+kdump_unpin_range(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
+		  size_t len)
+{
+	struct pinned_page *pp;
+	kdump_addr_t npages;
+	size_t pgsz, n;
+
+	clear_error(ctx);
+	rwlock_wrlock(&ctx->shared->lock);
+
+	if (len && ctx->pinned.n) {
+		pgsz = get_page_size(ctx);
+		npages = (addr % pgsz + len - 1) / pgsz + 1;
+		addr = page_align(ctx, addr);
+		n = 0;
+		for (pp = ctx->pinned.page;
+		     pp < ctx->pinned.page + ctx->pinned.n; ++pp) {
+			if (pp->as == as && pp->addr >= addr &&
+			    (pp->addr - addr) / pgsz < npages)
+				unpin_page(ctx, pp);
+			else
+				ctx->pinned.page[n++] = *pp;
+		}
+		ctx->pinned.n = n;
+	}
+
+	rwlock_unlock(&ctx->shared->lock);
+	return KDUMP_OK;
+}
+
+/**  Make sure that no pages are pinned.
+ * @param ctx  Dump file object.
+ * @returns    Error status.
+ *
+ * Pinned pages hold references to cache entries and file cache chunks,
+ * so the caches must not be reallocated while any page is pinned by
+ * any dump file object which shares them.
+ */
+kdump_status
+check_unpinned(kdump_ctx_t *ctx)
+{
+	if (ctx->shared->pinned_bytes.number)
+		return set_error(ctx, KDUMP_ERR_BUSY,
+				 "Cannot reallocate cache with pinned pages");
+	return KDUMP_OK;
+}
+
+/**  Release all pages pinned by a dump file object.
+ * @param ctx  Dump file object (write-locked).
+ */
+void
+unpin_all(kdump_ctx_t *ctx)
+{
+	while (ctx->pinned.n)
+		unpin_page(ctx, &ctx->pinned.page[--ctx->pinned.n]);
+	free(ctx->pinned.page);
+	ctx->pinned.page = NULL;
+	ctx->pinned.alloc = 0;
+}
+
 /**  Set read address spaces.
  * @param xlat    Address translation.
  * @param caps    Addrxlat capabilities.
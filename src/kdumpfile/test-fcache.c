@@ -336,6 +336,39 @@ test_chunks(struct fcache *fc)
 	return exitcode;
 }
 
+static int
+test_chunk_pool(struct fcache *fc)
+{
+	unsigned long nallocs;
+	struct fcache_chunk fch;
+	kdump_status status;
+	off_t pos;
+	size_t len;
+	int i;
+
+	/* Repeated reads of a large combined chunk must reuse buffers. */
+	pos = (pagesize << CACHE_ORDER) + pagesize - 8;
+	len = pagesize + 16;
+	nallocs = 0;
+	for (i = 0; i < 4; ++i) {
+		status = fcache_get_chunk(fc, &fch, len, pos);
+		if (status != KDUMP_OK) {
+			fprintf(stderr, "Cannot get %zd-byte chunk at %ld: %s\n",
+				len, (long)pos, kdump_strerror(status));
+			return TEST_ERR;
+		}
+		fcache_put_chunk(&fch);
+		if (i && fc->nallocs != nallocs) {
+			printf("chunk buffers allocated again: %lu -> %lu\n",
+			       nallocs, fc->nallocs);
+			exitcode = TEST_FAIL;
+		}
+		nallocs = fc->nallocs;
+	}
+
+	return exitcode;
+}
+
 static int
 test_fcache(struct fcache *fc)
 {
@@ -343,6 +376,9 @@ test_fcache(struct fcache *fc)
 
 	ret = test_basic(fc);
 	ret2 = test_chunks(fc);
+	if (ret < ret2)
+		ret = ret2;
+	ret2 = test_chunk_pool(fc);
 	if (ret < ret2)
 		ret = ret2;
 	return ret;
@@ -388,7 +424,7 @@ int
 main(int argc, char **argv)
 {
 	struct fcache *fc;
-	int ret;
+	int ret, ret2;
 
 	pagesize = sysconf(_SC_PAGESIZE);
 
@@ -416,7 +452,7 @@ main(int argc, char **argv)
 		return ret;
 	}
 
-	fc = fcache_new(dumpfd, CACHE_SIZE, CACHE_ORDER);
+	fc = fcache_new(dumpfd, CACHE_SIZE, CACHE_ORDER, false, 0);
 	if (!fc) {
 		perror("Allocation failure");
 		close(dumpfd);
@@ -425,6 +461,22 @@ main(int argc, char **argv)
 
 	ret = test_fcache(fc);
 	fcache_free(fc);
+
+	/* Read the same chunks with io_uring, if available. */
+	fc = fcache_new(dumpfd, CACHE_SIZE, CACHE_ORDER, false, 0);
+	if (!fc) {
+		perror("Allocation failure");
+		close(dumpfd);
+		return TEST_ERR;
+	}
+	if (fcache_use_uring(fc)) {
+		ret2 = test_chunks(fc);
+		if (ret < ret2)
+			ret = ret2;
+	} else
+		printf("io_uring not available\n");
+	fcache_free(fc);
+
 	close(dumpfd);
 	return ret;
 }
@@ -0,0 +1,421 @@
+/** @internal @file src/kdumpfile/uring.c
+ * @brief Asynchronous file I/O using io_uring.
+ */
+/* Copyright (C) 2026 agent <agent@local>
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include "kdumpfile-priv.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#if HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+#endif
+
+/* IORING_OP_READ and IORING_OP_FADVISE were added in Linux 5.6,
+ * together with this feature flag.
+ */
+#if HAVE_LINUX_IO_URING_H && defined(IORING_FEAT_RW_CUR_POS) && \
+	defined(SYS_io_uring_setup)
+
+/** User data of requests which nobody waits for. */
+#define URING_ASYNC	(~(__u64)0)
+
+/** Maximum length of one fadvise request.
+ * The length field of a submission queue entry has only 32 bits.
+ */
+#define URING_ADVISE_MAX	((off_t)1 << 30)
+
+/** io_uring instance.
+ */
+struct uring {
+	/** File descriptor of the ring. */
+	int fd;
+
+	/** Number of submission queue entries. */
+	unsigned entries;
+
+	/** Number of requests which have not completed yet. */
+	unsigned inflight;
+
+	/** Number of queued requests which have not been submitted. */
+	unsigned queued;
+
+	/** Set after a failed submission; the ring is not used again. */
+	bool failed;
+
+	/** Mapping of the submission queue ring. */
+	void *sq_ring;
+
+	/** Size of @c sq_ring. */
+	size_t sq_ring_sz;
+
+	/** Mapping of the completion queue ring. */
+	void *cq_ring;
+
+	/** Size of @c cq_ring. */
+	size_t cq_ring_sz;
+
+	/** Mapping of submission queue entries. */
+	struct io_uring_sqe *sqes;
+
+	/** Size of @c sqes. */
+	size_t sqes_sz;
+
+	/** @name Submission queue ring fields
+	 * @{
+	 */
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	/** @} */
+
+	/** @name Completion queue ring fields
+	 * @{
+	 */
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+	/** @} */
+};
+
+/**  Create an io_uring instance.
+ * @param entries  Number of submission queue entries.
+ * @returns        New instance, or @c NULL if io_uring is not available.
+ *
+ * io_uring may be missing in the kernel, disabled by the administrator,
+ * or blocked by a seccomp filter. In all these cases, the caller should
+ * fall back to synchronous I/O.
+ */
+struct uring *
+uring_new(unsigned entries)
+{
+	struct io_uring_params p;
+	struct uring *ring;
+
+	ring = calloc(1, sizeof *ring);
+	if (!ring)
+		return NULL;
+
+	memset(&p, 0, sizeof p);
+	ring->fd = syscall(SYS_io_uring_setup, entries, &p);
+	if (ring->fd < 0)
+		goto err_free;
+	if (!(p.features & IORING_FEAT_RW_CUR_POS))
+		goto err_close;
+	ring->entries = p.sq_entries;
+
+	ring->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_ring_sz = p.cq_off.cqes +
+		p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_ring_sz > ring->sq_ring_sz)
+			ring->sq_ring_sz = ring->cq_ring_sz;
+		ring->cq_ring_sz = 0;
+	}
+
+	ring->sq_ring = mmap(NULL, ring->sq_ring_sz, PROT_READ | PROT_WRITE,
+			     MAP_SHARED | MAP_POPULATE, ring->fd,
+			     IORING_OFF_SQ_RING);
+	if (ring->sq_ring == MAP_FAILED)
+		goto err_close;
+
+	if (ring->cq_ring_sz) {
+		ring->cq_ring = mmap(NULL, ring->cq_ring_sz,
+				     PROT_READ | PROT_WRITE,
+				     MAP_SHARED | MAP_POPULATE, ring->fd,
+				     IORING_OFF_CQ_RING);
+		if (ring->cq_ring == MAP_FAILED)
+			goto err_sq;
+	} else
+		ring->cq_ring = ring->sq_ring;
+
+	ring->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_sz, PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_POPULATE, ring->fd,
+			  IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED)
+		goto err_cq;
+
+	ring->sq_head = ring->sq_ring + p.sq_off.head;
+	ring->sq_tail = ring->sq_ring + p.sq_off.tail;
+	ring->sq_mask = ring->sq_ring + p.sq_off.ring_mask;
+	ring->sq_array = ring->sq_ring + p.sq_off.array;
+	ring->cq_head = ring->cq_ring + p.cq_off.head;
+	ring->cq_tail = ring->cq_ring + p.cq_off.tail;
+	ring->cq_mask = ring->cq_ring + p.cq_off.ring_mask;
+	ring->cqes = ring->cq_ring + p.cq_off.cqes;
+
+	return ring;
+
+ err_cq:
+	if (ring->cq_ring_sz)
+		munmap(ring->cq_ring, ring->cq_ring_sz);
+ err_sq:
+	munmap(ring->sq_ring, ring->sq_ring_sz);
+ err_close:
+	close(ring->fd);
+ err_free:
+	free(ring);
+	return NULL;
+}
+
+/**  Free an io_uring instance.
+ * @param ring  io_uring instance.
+ *
+ * Requests which are still in flight are cancelled by the kernel.
+ * Only requests which do not refer to any user memory (see
+ * @ref uring_advise) may be in flight at this point.
+ */
+void
+uring_free(struct uring *ring)
+{
+	munmap(ring->sqes, ring->sqes_sz);
+	if (ring->cq_ring_sz)
+		munmap(ring->cq_ring, ring->cq_ring_sz);
+	munmap(ring->sq_ring, ring->sq_ring_sz);
+	close(ring->fd);
+	free(ring);
+}
+
+/**  Get a free submission queue entry.
+ * @param ring  io_uring instance.
+ * @returns     Cleared submission queue entry, or @c NULL if the ring
+ *              is full.
+ *
+ * The number of requests which are queued or in flight never exceeds
+ * the size of the submission queue. Since the completion queue is
+ * bigger, it cannot overflow.
+ *
+ * The entry is added to the ring immediately, but the kernel does not
+ * look at it until the next call to @ref submit, so the caller can
+ * fill it in afterwards.
+ */
+static struct io_uring_sqe *
+get_sqe(struct uring *ring)
+{
+	struct io_uring_sqe *sqe;
+	unsigned tail, idx;
+
+	if (ring->inflight + ring->queued >= ring->entries)
+		return NULL;
+
+	tail = *ring->sq_tail;
+	idx = tail & *ring->sq_mask;
+	sqe = &ring->sqes[idx];
+	memset(sqe, 0, sizeof *sqe);
+	ring->sq_array[idx] = idx;
+	__sync_synchronize();
+	*ring->sq_tail = tail + 1;
+	++ring->queued;
+	return sqe;
+}
+
+/**  Submit queued requests and optionally wait for completions.
+ * @param ring  io_uring instance.
+ * @param wait  Wait for at least one completion.
+ * @returns     Zero on success, or a negative error number.
+ */
+static int
+submit(struct uring *ring, bool wait)
+{
+	int ret;
+
+	__sync_synchronize();
+	do {
+		ret = syscall(SYS_io_uring_enter, ring->fd, ring->queued,
+			      wait ? 1 : 0,
+			      wait ? IORING_ENTER_GETEVENTS : 0,
+			      NULL, 0);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0) {
+		ret = -errno;
+		if (ret != -EAGAIN && ret != -EBUSY)
+			ring->failed = true;
+		return ret;
+	}
+
+	ring->queued -= ret;
+	ring->inflight += ret;
+	return 0;
+}
+
+/**  Remove queued requests which have not been submitted.
+ * @param ring  io_uring instance.
+ *
+ * The kernel does not look at the submission queue until the next
+ * io_uring_enter call, so the entries can be simply taken back. This
+ * must be done before returning from a function which queued requests
+ * that refer to its local variables.
+ */
+static void
+unqueue(struct uring *ring)
+{
+	*ring->sq_tail -= ring->queued;
+	ring->queued = 0;
+}
+
+/**  Reap completed requests.
+ * @param ring  io_uring instance.
+ * @param rd    Read requests which are waited for (may be @c NULL).
+ * @returns     Number of completed requests from @p rd.
+ */
+static unsigned
+reap(struct uring *ring, struct uring_read *rd)
+{
+	struct io_uring_cqe *cqe;
+	unsigned head, done = 0;
+
+	head = *ring->cq_head;
+	__sync_synchronize();
+	while (head != *ring->cq_tail) {
+		cqe = &ring->cqes[head & *ring->cq_mask];
+		if (cqe->user_data != URING_ASYNC) {
+			rd[cqe->user_data].res = cqe->res;
+			++done;
+		}
+		--ring->inflight;
+		++head;
+	}
+	__sync_synchronize();
+	*ring->cq_head = head;
+	return done;
+}
+
+/**  Read data at multiple file positions.
+ * @param ring  io_uring instance.
+ * @param fd    File descriptor.
+ * @param rd    Read requests.
+ * @param n     Number of requests in @p rd.
+ * @returns     Zero on success, or a negative error number.
+ *
+ * All requests are submitted at once (or in as few batches as the ring
+ * size allows), and the function returns after all of them complete.
+ * The result of each request is stored in its @c res field. If this
+ * function fails, the results are undefined, and the caller should read
+ * the data in another way. No request for @p rd is left in the ring
+ * when this function returns.
+ */
+int
+uring_read(struct uring *ring, int fd, struct uring_read *rd, unsigned n)
+{
+	struct io_uring_sqe *sqe;
+	unsigned i = 0, done = 0;
+	int ret;
+
+	if (ring->failed)
+		return -EIO;
+
+	while (done < n) {
+		for ( ; i < n && (sqe = get_sqe(ring)); ++i) {
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = fd;
+			sqe->addr = (unsigned long) rd[i].buf;
+			sqe->len = rd[i].len;
+			sqe->off = rd[i].pos;
+			sqe->user_data = i;
+		}
+
+		ret = submit(ring, true);
+		if (ret == -EAGAIN || ret == -EBUSY)
+			ret = submit(ring, false);
+		if (ret && !ring->inflight) {
+			unqueue(ring);
+			return ret;
+		}
+		done += reap(ring, rd);
+	}
+	return 0;
+}
+
+/**  Start reading a file range into the page cache.
+ * @param ring  io_uring instance.
+ * @param fd    File descriptor.
+ * @param pos   File position.
+ * @param len   Length of the range.
+ *
+ * This function does not wait for the I/O. If the ring is full, the
+ * rest of the range is ignored, because the request is only a hint.
+ */
+void
+uring_advise(struct uring *ring, int fd, off_t pos, off_t len)
+{
+	struct io_uring_sqe *sqe;
+
+	if (ring->failed)
+		return;
+
+	reap(ring, NULL);
+	while (len > 0 && (sqe = get_sqe(ring))) {
+		sqe->opcode = IORING_OP_FADVISE;
+		sqe->fd = fd;
+		sqe->off = pos;
+		sqe->len = len < URING_ADVISE_MAX ? len : URING_ADVISE_MAX;
+		sqe->fadvise_advice = POSIX_FADV_WILLNEED;
+		sqe->user_data = URING_ASYNC;
+		pos += sqe->len;
+		len -= sqe->len;
+	}
+	if (ring->queued)
+		submit(ring, false);
+}
+
+#else  /* io_uring not available */
+
+struct uring *
+uring_new(unsigned entries)
+{
+	return NULL;
+}
+
+void
+uring_free(struct uring *ring)
+{
+}
+
+int
+uring_read(struct uring *ring, int fd, struct uring_read *rd, unsigned n)
+{
+	return -ENOSYS;
+}
+
+void
+uring_advise(struct uring *ring, int fd, off_t pos, off_t len)
+{
+}
+
+#endif	/* io_uring not available */
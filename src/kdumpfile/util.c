@@ -37,6 +37,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <sys/mman.h>
 
 #if USE_ZLIB
 # include <zlib.h>
@@ -140,6 +141,205 @@ ctx_malloc(size_t size, kdump_ctx_t *ctx, const char *desc)
 	return ret;
 }
 
+/**  Read a number from the first matching line of a text file.
+ * @param path    File name.
+ * @param prefix  Line prefix (including any separator).
+ * @returns       The number, or zero if not found.
+ */
+static unsigned long long
+read_num_file(const char *path, const char *prefix)
+{
+	size_t len = strlen(prefix);
+	unsigned long long ret = 0;
+	char line[128];
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (!f)
+		return 0;
+	while (fgets(line, sizeof line, f))
+		if (!strncmp(line, prefix, len)) {
+			ret = strtoull(line + len, NULL, 10);
+			break;
+		}
+	fclose(f);
+	return ret;
+}
+
+/**  Get the size of a huge page.
+ * @param mode  Huge page type (@c dm_thp or @c dm_hugetlb).
+ * @returns     Huge page size in bytes, or zero if not available.
+ */
+static size_t
+huge_page_size(enum data_mode mode)
+{
+	if (mode == dm_hugetlb)
+		return read_num_file("/proc/meminfo", "Hugepagesize:") << 10;
+	return read_num_file("/sys/kernel/mm/transparent_hugepage/"
+			     "hpage_pmd_size", "");
+}
+
+/**  Map a data area with huge pages of a given type.
+ * @param area  Data area (filled in on success).
+ * @param size  Requested size.
+ * @param mode  Huge page type (@c dm_thp or @c dm_hugetlb).
+ * @returns     @c true on success, @c false on failure.
+ *
+ * Areas smaller than a huge page are not mapped, because they would
+ * waste more memory than they could save in TLB misses. Transparent
+ * huge pages can only be used for aligned ranges, so the mapping is
+ * aligned to the huge page size.
+ */
+static bool
+map_huge(struct data_area *area, size_t size, enum data_mode mode)
+{
+	size_t pagesz = huge_page_size(mode);
+	size_t len, extra;
+	char *ptr;
+	int flags;
+
+	if (!pagesz || size < pagesz)
+		return false;
+	len = (size + pagesz - 1) & ~(pagesz - 1);
+	if (len < size)
+		return false;
+
+	flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	extra = 0;
+	if (mode == dm_hugetlb) {
+#ifdef MAP_HUGETLB
+		flags |= MAP_HUGETLB;
+#else
+		return false;
+#endif
+	} else
+		extra = pagesz;
+
+	ptr = mmap(NULL, len + extra, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (ptr == MAP_FAILED)
+		return false;
+
+	if (extra) {
+		size_t head = -(uintptr_t)ptr & (pagesz - 1);
+		if (head)
+			munmap(ptr, head);
+		if (extra - head)
+			munmap(ptr + head + len, extra - head);
+		ptr += head;
+#ifdef MADV_HUGEPAGE
+		if (madvise(ptr, len, MADV_HUGEPAGE)) {
+			munmap(ptr, len);
+			return false;
+		}
+#else
+		munmap(ptr, len);
+		return false;
+#endif
+	}
+
+	area->ptr = ptr;
+	area->size = len;
+	area->mode = mode;
+	return true;
+}
+
+/**  Allocate a data area backed by huge pages.
+ * @param area  Data area (filled in on success).
+ * @param size  Requested size.
+ * @returns     @c true on success, @c false if huge pages are not
+ *              available.
+ *
+ * Pages from the huge page pool are preferred. If the pool is not
+ * configured (or too small), fall back to transparent huge pages.
+ */
+bool
+huge_area_alloc(struct data_area *area, size_t size)
+{
+	return map_huge(area, size, dm_hugetlb) ||
+		map_huge(area, size, dm_thp);
+}
+
+/**  Allocate a data area.
+ * @param area  Data area (filled in on success).
+ * @param size  Requested size.
+ * @param huge  Try to use huge pages.
+ * @returns     @c true on success, @c false on allocation failure.
+ *
+ * If huge pages are not available, the area is allocated with malloc().
+ */
+bool
+data_area_alloc(struct data_area *area, size_t size, bool huge)
+{
+	if (huge && huge_area_alloc(area, size))
+		return true;
+
+	area->ptr = malloc(size);
+	area->size = size;
+	area->mode = dm_malloc;
+	return area->ptr != NULL;
+}
+
+/**  Allocate a data area on a NUMA node.
+ * @param area  Data area (filled in on success).
+ * @param size  Requested size.
+ * @param huge  Try to use huge pages.
+ * @param numa  NUMA topology.
+ * @param node  Node index.
+ * @returns     @c true on success, @c false on allocation failure.
+ *
+ * The area is always mapped (with huge pages if requested and
+ * available), so that its memory can be placed on @p node. Placement
+ * is best-effort; the area is usable even if the node cannot be set.
+ */
+bool
+node_area_alloc(struct data_area *area, size_t size, bool huge,
+		const struct numa_topology *numa, unsigned node)
+{
+	if (!huge || !huge_area_alloc(area, size)) {
+		void *ptr;
+
+		if (!size)
+			return false;
+		ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+			return false;
+		area->ptr = ptr;
+		area->size = size;
+		area->mode = dm_mmap;
+	}
+
+	numa_bind(numa, node, area->ptr, area->size);
+	return true;
+}
+
+/**  Free a data area.
+ * @param area  Data area.
+ */
+void
+data_area_free(struct data_area *area)
+{
+	if (area->mode == dm_malloc)
+		free(area->ptr);
+	else
+		munmap(area->ptr, area->size);
+}
+
+/**  Get the name of a data area backing type.
+ * @param mode  Backing memory type.
+ * @returns     Name of the type (used as an attribute value).
+ */
+const char *
+data_mode_name(enum data_mode mode)
+{
+	switch (mode) {
+	case dm_mmap:		return "mmap";
+	case dm_thp:		return "thp";
+	case dm_hugetlb:	return "hugetlb";
+	default:		return "malloc";
+	}
+}
+
 static inline void
 add_to_hash(unsigned long *hash, unsigned long x)
 {
@@ -422,6 +622,12 @@ page_size_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
 		   kdump_attr_value_t *newval)
 {
 	size_t page_size = newval->number;
+	kdump_status status;
+
+	/* Pinned pages are accounted in units of the current page size. */
+	status = check_unpinned(ctx);
+	if (status != KDUMP_OK)
+		return status;
 
 	/* It must be a power of 2 */
 	if (page_size != (page_size & ~(page_size - 1)))
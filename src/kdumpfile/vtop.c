@@ -373,69 +373,216 @@ const struct attr_ops xen_dirty_xlat_ops = {
 	.pre_clear = (attr_pre_clear_fn*)xen_dirty_xlat_hook,
 };
 
-/**  Add a cached read chunk.
- * @param cache  Read cache.
- * @param key    New entry key.
- * @param p      Buffer address.
- * @returns      New cache entry slot.
+static kdump_status
+xlat_cache_stats_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	unsigned long hits = 0, misses = 0;
+	kdump_ctx_t *cur;
+
+	list_for_each_entry(cur, &ctx->shared->ctx, list) {
+		hits += cur->cached.hits;
+		misses += cur->cached.misses;
+	}
+	ctx->shared->xlat_cache_hits.number = hits;
+	ctx->shared->xlat_cache_misses.number = misses;
+	return KDUMP_OK;
+}
+
+/**  Statistics of the address translation read cache.
+ * The read cache is per-context, so the values are summed up over all
+ * dump file objects which share the same dump file.
  */
-static unsigned
-cached_read_insert(struct cached_reads *cache, addrxlat_addr_t key, void *p)
+const struct attr_ops xlat_cache_stats_ops = {
+	.revalidate = xlat_cache_stats_revalidate,
+};
+
+static kdump_status
+xlat_cache_pages_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
+			  kdump_attr_value_t *val)
 {
-	unsigned slot;
+	if (val->number > MAX_READ_CACHE_PAGES)
+		return set_error(ctx, KDUMP_ERR_INVALID,
+				 "Read cache too big (max %u pages)",
+				 MAX_READ_CACHE_PAGES);
+	return KDUMP_OK;
+}
 
-	slot = (cache->slot + READ_CACHE_SLOTS - 1) % READ_CACHE_SLOTS;
-	cache->slot = slot;
-	cache->key[slot] = key;
-	memcpy(cache->val[slot], p, sizeof(cache->val[slot]));
-	return slot;
+/**  Size of the address translation read cache.
+ * The number of pages is rounded up to an even number.
+ */
+const struct attr_ops xlat_cache_pages_ops = {
+	.pre_set = xlat_cache_pages_pre_hook,
+};
+
+/**  Invalidate all pages held by a read cache.
+ * @param ctx  Dump file object.
+ */
+static void
+cached_reads_release(kdump_ctx_t *ctx)
+{
+	struct cached_reads *cache = &ctx->cached;
+	unsigned i;
+
+	for (i = 0; i < 2 * cache->nsets; ++i)
+		cache->key[i] = ADDRXLAT_NOADDR;
 }
 
-/**  Addrxlat read32 callback.
- * @param data  Dump file object.
+/**  Free the read cache of a dump file object.
+ * @param ctx  Dump file object (shared data locked for writing).
+ */
+void
+cached_reads_free(kdump_ctx_t *ctx)
+{
+	struct cached_reads *cache = &ctx->cached;
+
+	if (cache->nsets)
+		cached_reads_release(ctx);
+	free(cache->key);
+	free(cache->page);
+	free(cache->data);
+	cache->key = NULL;
+	cache->page = NULL;
+	cache->data = NULL;
+	cache->nsets = 0;
+}
+
+/**  Invalidate all read caches.
+ * @param shared  Dump file shared data (locked for writing).
+ *
+ * This function must be called when the cached data may no longer be
+ * valid, e.g. when the page cache is re-allocated.
+ */
+void
+cached_reads_flush(struct kdump_shared *shared)
+{
+	kdump_ctx_t *cur;
+
+	list_for_each_entry(cur, &shared->ctx, list)
+		if (cur->cached.nsets)
+			cached_reads_release(cur);
+}
+
+/**  Make sure the read cache has the configured size.
+ * @param ctx  Dump file object.
+ *
+ * If memory cannot be allocated, pages are simply not cached.
+ */
+static void
+cached_reads_resize(kdump_ctx_t *ctx)
+{
+	struct cached_reads *cache = &ctx->cached;
+	unsigned i, nsets = (get_xlat_cache_pages(ctx) + 1) / 2;
+
+	if (cache->nsets == nsets && cache->shift == get_page_shift(ctx))
+		return;
+
+	cached_reads_free(ctx);
+	cache->shift = get_page_shift(ctx);
+	if (!nsets)
+		return;
+
+	cache->key = malloc(2 * nsets * sizeof(*cache->key));
+	cache->page = malloc(2 * nsets * sizeof(*cache->page));
+	cache->data = malloc((size_t)2 * nsets << cache->shift);
+	if (!cache->key || !cache->page || !cache->data) {
+		cached_reads_free(ctx);
+		return;
+	}
+	for (i = 0; i < 2 * nsets; ++i) {
+		cache->key[i] = ADDRXLAT_NOADDR;
+		cache->page[i] = cache->data + ((size_t)i << cache->shift);
+	}
+	cache->nsets = nsets;
+}
+
+/**  Get the first slot of the read cache set for a page.
+ * @param cache  Read cache (non-empty).
+ * @param key    Page address combined with its address space.
+ * @returns      Slot index.
+ */
+static inline unsigned
+cached_read_slot(const struct cached_reads *cache, addrxlat_addr_t key)
+{
+	uint32_t hash = ((key >> cache->shift) * 0x9e3779b97f4a7c15ULL) >> 32;
+	return 2 * (((uint64_t)hash * cache->nsets) >> 32);
+}
+
+/**  Read a value through the read cache.
+ * @param ctx   Dump file object.
  * @param addr  Value address.
- * @param val   Pointer to resulting variable.
+ * @param val   Buffer for the (raw) value.
+ * @param sz    Size of the value.
  * @returns     Error status.
  *
- * This function fails if data crosses a page boundary.
+ * The value must not cross a page boundary.
+ *
+ * Whole pages are copied into the read cache, so that it does not hold
+ * any references to the shared page cache between calls.
  */
 static addrxlat_status
-addrxlat_read32(void *data, const addrxlat_fulladdr_t *addr, uint32_t *val)
+cached_read(kdump_ctx_t *ctx, const addrxlat_fulladdr_t *addr,
+	    void *val, size_t sz)
 {
-	kdump_ctx_t *ctx = (kdump_ctx_t*) data;
+	struct cached_reads *cache = &ctx->cached;
 	struct page_io pio;
-	uint32_t *p;
-	addrxlat_addr_t aligned;
-	unsigned slot, off;
+	unsigned char *tmp;
+	addrxlat_addr_t key;
+	unsigned slot;
+	size_t off;
 	kdump_status status;
 
-	off = addr->addr & (READ_CACHE_SIZE - 1);
-	aligned = addr->addr - off;
-	slot = ctx->cached.slot;
-	do {
-		if (ctx->cached.key[slot] == (aligned | addr->as))
-			goto out;
-		slot = (slot + 1) % READ_CACHE_SLOTS;
-	} while (slot != ctx->cached.slot);
+	cached_reads_resize(ctx);
 
 	pio.addr.addr = page_align(ctx, addr->addr);
 	pio.addr.as = addr->as;
+	off = addr->addr - pio.addr.addr;
+
+	if (!cache->nsets) {
+		++cache->misses;
+		status = ctx->shared->ops->get_page(ctx, &pio);
+		if (status != KDUMP_OK)
+			return kdump2addrxlat(ctx, status);
+		memcpy(val, pio.chunk.data + off, sz);
+		put_page(ctx, &pio);
+		return ADDRXLAT_OK;
+	}
+
+	key = pio.addr.addr | pio.addr.as;
+	slot = cached_read_slot(cache, key);
+	if (cache->key[slot] == key) {
+		++cache->hits;
+		goto out;
+	}
+	if (cache->key[slot + 1] == key) {
+		++cache->hits;
+		tmp = cache->page[slot + 1];
+		cache->page[slot + 1] = cache->page[slot];
+		cache->page[slot] = tmp;
+		cache->key[slot + 1] = cache->key[slot];
+		cache->key[slot] = key;
+		goto out;
+	}
+	++cache->misses;
 
 	status = ctx->shared->ops->get_page(ctx, &pio);
 	if (status != KDUMP_OK)
 		return kdump2addrxlat(ctx, status);
 
-	p = pio.chunk.data + (aligned & (get_page_size(ctx) - 1));
-	slot = cached_read_insert(&ctx->cached, aligned | addr->as, p);
+	/* The new page replaces the LRU page of the set. */
+	tmp = cache->page[slot + 1];
+	cache->page[slot + 1] = cache->page[slot];
+	cache->key[slot + 1] = cache->key[slot];
+	cache->page[slot] = tmp;
+	cache->key[slot] = key;
+	memcpy(tmp, pio.chunk.data, (size_t)1 << cache->shift);
 	put_page(ctx, &pio);
 
  out:
-	p = (uint32_t*)(ctx->cached.val[slot] + off);
-	*val = dump32toh(ctx, *p);
+	memcpy(val, cache->page[slot] + off, sz);
 	return ADDRXLAT_OK;
 }
 
-/**  Addrxlat read64 callback.
+/**  Addrxlat read32 callback.
  * @param data  Dump file object.
  * @param addr  Value address.
  * @param val   Pointer to resulting variable.
@@ -444,39 +591,37 @@ addrxlat_read32(void *data, const addrxlat_fulladdr_t *addr, uint32_t *val)
  * This function fails if data crosses a page boundary.
  */
 static addrxlat_status
-addrxlat_read64(void *data, const addrxlat_fulladdr_t *addr, uint64_t *val)
+addrxlat_read32(void *data, const addrxlat_fulladdr_t *addr, uint32_t *val)
 {
 	kdump_ctx_t *ctx = (kdump_ctx_t*) data;
-	struct page_io pio;
-	uint64_t *p;
-	addrxlat_addr_t aligned;
-	unsigned slot, off;
-	kdump_status status;
+	uint32_t raw;
+	addrxlat_status status;
 
-	off = addr->addr & (READ_CACHE_SIZE - 1);
-	aligned = addr->addr - off;
-	slot = ctx->cached.slot;
-	do {
-		if (ctx->cached.key[slot] == (aligned | addr->as))
-			goto out;
-		slot = (slot + 1) % READ_CACHE_SLOTS;
-	} while (slot != ctx->cached.slot);
-
-	pio.addr.addr = page_align(ctx, addr->addr);
-	pio.addr.as = addr->as;
-
-	status = ctx->shared->ops->get_page(ctx, &pio);
-	if (status != KDUMP_OK)
-		return kdump2addrxlat(ctx, status);
+	status = cached_read(ctx, addr, &raw, sizeof raw);
+	if (status == ADDRXLAT_OK)
+		*val = dump32toh(ctx, raw);
+	return status;
+}
 
-	p = pio.chunk.data + (aligned & (get_page_size(ctx) - 1));
-	slot = cached_read_insert(&ctx->cached, aligned | addr->as, p);
-	put_page(ctx, &pio);
+/**  Addrxlat read64 callback.
+ * @param data  Dump file object.
+ * @param addr  Value address.
+ * @param val   Pointer to resulting variable.
+ * @returns     Error status.
+ *
+ * This function fails if data crosses a page boundary.
+ */
+static addrxlat_status
+addrxlat_read64(void *data, const addrxlat_fulladdr_t *addr, uint64_t *val)
+{
+	kdump_ctx_t *ctx = (kdump_ctx_t*) data;
+	uint64_t raw;
+	addrxlat_status status;
 
- out:
-	p = (uint64_t*)(ctx->cached.val[slot] + off);
-	*val = dump64toh(ctx, *p);
-	return ADDRXLAT_OK;
+	status = cached_read(ctx, addr, &raw, sizeof raw);
+	if (status == ADDRXLAT_OK)
+		*val = dump64toh(ctx, raw);
+	return status;
 }
 
 static addrxlat_status
@@ -102,8 +102,57 @@ rwlock_unlock(rwlock_t *rwlock)
 	return pthread_rwlock_unlock(rwlock);
 }
 
+typedef pthread_cond_t cond_t;
+typedef pthread_condattr_t condattr_t;
+
+static inline int
+cond_init(cond_t *cond, const condattr_t *attr)
+{
+	return pthread_cond_init(cond, attr);
+}
+
+static inline int
+cond_destroy(cond_t *cond)
+{
+	return pthread_cond_destroy(cond);
+}
+
+static inline int
+cond_wait(cond_t *cond, mutex_t *mutex)
+{
+	return pthread_cond_wait(cond, mutex);
+}
+
+static inline int
+cond_signal(cond_t *cond)
+{
+	return pthread_cond_signal(cond);
+}
+
+static inline int
+cond_broadcast(cond_t *cond)
+{
+	return pthread_cond_broadcast(cond);
+}
+
+typedef pthread_t thread_t;
+
+static inline int
+thread_create(thread_t *thread, void *(*fn)(void *), void *arg)
+{
+	return pthread_create(thread, NULL, fn, arg);
+}
+
+static inline int
+thread_detach(thread_t thread)
+{
+	return pthread_detach(thread);
+}
+
 #else  /* USE_PTHREAD */
 
+#include <errno.h>
+
 typedef struct { } mutex_t;
 typedef struct { } mutexattr_t;
 
@@ -170,6 +219,55 @@ rwlock_unlock(rwlock_t *rwlock)
 	return 0;
 }
 
+typedef struct { } cond_t;
+typedef struct { } condattr_t;
+
+static inline int
+cond_init(cond_t *cond, const condattr_t *attr)
+{
+	return 0;
+}
+
+static inline int
+cond_destroy(cond_t *cond)
+{
+	return 0;
+}
+
+/* Without threads, nobody else can wake up the waiter. */
+static inline int
+cond_wait(cond_t *cond, mutex_t *mutex)
+{
+	return -1;
+}
+
+static inline int
+cond_signal(cond_t *cond)
+{
+	return 0;
+}
+
+static inline int
+cond_broadcast(cond_t *cond)
+{
+	return 0;
+}
+
+typedef struct { } thread_t;
+
+/* Threads cannot be created without thread support. */
+static inline int
+thread_create(thread_t *thread, void *(*fn)(void *), void *arg)
+{
+	return ENOSYS;
+}
+
+static inline int
+thread_detach(thread_t thread)
+{
+	return 0;
+}
+
 #endif
 
 #endif	/* threads.h */
@@ -41,15 +41,172 @@
 #define DEFITER		1000
 #define DEFTHREADS	1
 
+/* Number of bytes read by each request of a batch. */
+#define BATCH_BYTES	64
+
 static unsigned long base_pfn, npages;
 static unsigned long niter = DEFITER;
+static int cache_wait;
+static int check_data;
+static int hugepages;
+static int numa;
+static int sequential;
+static int prefetch;
+static int zerocopy;
+static unsigned long batch;
+static unsigned long span;
+static long ra_window = -1;
+static unsigned long prefetch_threads;
+static unsigned long long cache_max_bytes;
+static const char *pcache_path;
+static long map_file = -1;
+static long fcache_order = -1;
+static unsigned long fcache_windows;
+static int fcache_adaptive;
+static int use_uring;
+static const char *fcache_advice;
+static const char *cache_policy;
+static unsigned long npinned;
+static long l1_pages = -1;
+static int scan;
+
+/* Check that every byte of @p buf equals the low byte of its PFN.
+ * This is the data pattern of dumps created by the diskdump tests.
+ */
+static int
+data_ok(const void *buf, size_t len, unsigned long pfn)
+{
+	const unsigned char *p = buf;
+	size_t i;
+
+	for (i = 0; i < len; ++i)
+		if (p[i] != (unsigned char) pfn)
+			return 0;
+	return 1;
+}
+
+static void *
+run_batched_reads(kdump_ctx_t *ctx, kdump_num_t page_shift)
+{
+	size_t pgsz = (size_t)1 << page_shift;
+	kdump_iovec_t iov[batch];
+	char buf[batch][BATCH_BYTES];
+	unsigned long pfn, start;
+	unsigned i, j;
+	kdump_status res;
+
+	start = lrand48();
+	for (i = 0; i < niter; i += batch) {
+		for (j = 0; j < batch; ++j) {
+			pfn = base_pfn + (sequential
+					  ? (start + i + j) % npages
+					  : lrand48() % npages);
+			memset(buf[j], ~pfn, BATCH_BYTES);
+			iov[j].as = KDUMP_MACHPHYSADDR;
+			iov[j].addr = (pfn << page_shift) +
+				lrand48() % (pgsz - BATCH_BYTES + 1);
+			iov[j].buf = buf[j];
+			iov[j].len = BATCH_BYTES;
+		}
+		res = kdump_readv(ctx, iov, batch);
+		if (res != KDUMP_OK) {
+			for (j = 0; iov[j].status == KDUMP_OK; ++j)
+				;
+			fprintf(stderr, "Read failed at 0x%llx\n",
+				(unsigned long long) iov[j].addr);
+			return (void*) kdump_get_err(ctx);
+		}
+
+		for (j = 0; j < batch; ++j) {
+			if (iov[j].len != BATCH_BYTES) {
+				fprintf(stderr, "Short read at 0x%llx: %zu\n",
+					(unsigned long long) iov[j].addr,
+					iov[j].len);
+				return "Short read";
+			}
+			if (check_data &&
+			    !data_ok(iov[j].buf, iov[j].len,
+				     iov[j].addr >> page_shift)) {
+				fprintf(stderr, "Data mismatch at 0x%llx\n",
+					(unsigned long long) iov[j].addr);
+				return "Data mismatch";
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Read multiple pages at once and check each of them against a read
+ * of a single byte from the same page.
+ */
+static void *
+run_span_reads(kdump_ctx_t *ctx, kdump_num_t page_shift)
+{
+	size_t pgsz = (size_t)1 << page_shift;
+	char *buf;
+	unsigned long pfn, start;
+	char byte;
+	size_t sz;
+	unsigned i, j;
+	kdump_status res;
+
+	buf = malloc(span << page_shift);
+	if (!buf)
+		return "Cannot allocate read buffer";
+
+	start = lrand48();
+	for (i = 0; i < niter; ++i) {
+		pfn = base_pfn + (sequential
+				  ? (start + i * span) % (npages - span + 1)
+				  : lrand48() % (npages - span + 1));
+		sz = span << page_shift;
+		res = kdump_read(ctx, KDUMP_MACHPHYSADDR, pfn << page_shift,
+				 buf, &sz);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Read failed at 0x%llx\n",
+				(unsigned long long) pfn << page_shift);
+			free(buf);
+			return (void*) kdump_get_err(ctx);
+		}
+		for (j = 0; check_data && j < span; ++j) {
+			if (!data_ok(buf + j * pgsz, pgsz, pfn + j)) {
+				fprintf(stderr, "Data mismatch at 0x%llx\n",
+					(unsigned long long)
+					(pfn + j) << page_shift);
+				free(buf);
+				return "Data mismatch";
+			}
+		}
+
+		for (j = 0; j < span; ++j) {
+			sz = 1;
+			res = kdump_read(ctx, KDUMP_MACHPHYSADDR,
+					 (pfn + j) << page_shift, &byte, &sz);
+			if (res != KDUMP_OK) {
+				free(buf);
+				return (void*) kdump_get_err(ctx);
+			}
+			if (byte != buf[j * pgsz]) {
+				fprintf(stderr, "Data mismatch at 0x%llx\n",
+					(unsigned long long)
+					(pfn + j) << page_shift);
+				free(buf);
+				return "Data mismatch";
+			}
+		}
+	}
+
+	free(buf);
+	return NULL;
+}
 
 static void *
 run_reads(void *arg)
 {
 	kdump_ctx_t *ctx = arg;
 	kdump_num_t page_shift;
-	unsigned long pfn;
+	unsigned long pfn, start;
 	char buf[1];
 	size_t sz;
 	unsigned i;
@@ -59,21 +216,136 @@ run_reads(void *arg)
 	if (res != KDUMP_OK)
 		return (void*) kdump_get_err(ctx);
 
+	if (prefetch) {
+		res = kdump_prefetch(ctx, KDUMP_MACHPHYSADDR,
+				     base_pfn << page_shift,
+				     npages << page_shift,
+				     KDUMP_PREFETCH_ASYNC);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Prefetch failed\n");
+			return (void*) kdump_get_err(ctx);
+		}
+	}
+
+	if (batch)
+		return run_batched_reads(ctx, page_shift);
+	if (span)
+		return run_span_reads(ctx, page_shift);
+
 	sz = sizeof buf;
+	start = lrand48();
 	for (i = 0; i < niter; ++i) {
-		pfn = base_pfn + lrand48() % npages;
-		res = kdump_read(ctx, KDUMP_MACHPHYSADDR, pfn << page_shift,
-				 &buf, &sz);
+		pfn = base_pfn + (sequential
+				  ? (start + i) % npages
+				  : lrand48() % npages);
+		if (zerocopy) {
+			kdump_page_t *page;
+			res = kdump_get_page(ctx, KDUMP_MACHPHYSADDR,
+					     pfn << page_shift, &page);
+			if (res == KDUMP_OK) {
+				const void *data = kdump_page_data(page);
+				buf[0] = *(const char*)data;
+				/* Check the whole page; a mismatch is then
+				 * reported by the check of buf below. */
+				if (check_data &&
+				    !data_ok(data, (size_t)1 << page_shift, pfn))
+					buf[0] = ~pfn;
+				kdump_put_page(ctx, page);
+			}
+		} else
+			res = kdump_read(ctx, KDUMP_MACHPHYSADDR,
+					 pfn << page_shift, &buf, &sz);
 		if (res != KDUMP_OK) {
 			fprintf(stderr, "Read failed at 0x%llx\n",
 				(unsigned long long) pfn << page_shift);
 			return (void*) kdump_get_err(ctx);
 		}
+		if (check_data && !data_ok(buf, sizeof buf, pfn)) {
+			fprintf(stderr, "Data mismatch at 0x%llx\n",
+				(unsigned long long) pfn << page_shift);
+			return "Data mismatch";
+		}
 	}
 
 	return NULL;
 }
 
+static int
+pin_pages(kdump_ctx_t *ctx)
+{
+	kdump_num_t page_shift, pinned;
+	kdump_status res;
+
+	res = kdump_get_number_attr(ctx, KDUMP_ATTR_PAGE_SHIFT, &page_shift);
+	if (res == KDUMP_OK)
+		res = kdump_pin_range(ctx, KDUMP_MACHPHYSADDR,
+				      base_pfn << page_shift,
+				      npinned << page_shift);
+	if (res == KDUMP_OK)
+		res = kdump_get_number_attr(ctx, "cache.pinned_bytes",
+					    &pinned);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot pin pages: %s\n", kdump_get_err(ctx));
+		return TEST_ERR;
+	}
+	printf("Pinned %llu bytes\n", (unsigned long long) pinned);
+	return TEST_OK;
+}
+
+static int
+get_evictions(kdump_ctx_t *ctx, kdump_num_t *evictions)
+{
+	kdump_status res;
+
+	res = kdump_get_number_attr(ctx, "cache.evictions", evictions);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot get cache evictions: %s\n",
+			kdump_get_err(ctx));
+		return TEST_ERR;
+	}
+	return TEST_OK;
+}
+
+/* Read all pinned pages (backwards, to avoid read-ahead) and check
+ * that none of them causes a cache miss.
+ */
+static int
+check_pinned(kdump_ctx_t *ctx)
+{
+	kdump_num_t page_shift, before, after;
+	unsigned long pfn;
+	char buf[1];
+	size_t sz;
+	kdump_status res;
+
+	res = kdump_get_number_attr(ctx, KDUMP_ATTR_PAGE_SHIFT, &page_shift);
+	if (res == KDUMP_OK)
+		res = kdump_get_number_attr(ctx, "cache.misses", &before);
+	for (pfn = base_pfn + npinned; res == KDUMP_OK && pfn > base_pfn; ) {
+		--pfn;
+		sz = sizeof buf;
+		res = kdump_read(ctx, KDUMP_MACHPHYSADDR, pfn << page_shift,
+				 buf, &sz);
+	}
+	if (res == KDUMP_OK)
+		res = kdump_get_number_attr(ctx, "cache.misses", &after);
+	if (res == KDUMP_OK)
+		res = kdump_unpin_range(ctx, KDUMP_MACHPHYSADDR,
+					base_pfn << page_shift,
+					npinned << page_shift);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot check pinned pages: %s\n",
+			kdump_get_err(ctx));
+		return TEST_ERR;
+	}
+	if (after != before) {
+		fprintf(stderr, "%llu pinned pages were evicted\n",
+			(unsigned long long) (after - before));
+		return TEST_FAIL;
+	}
+	return TEST_OK;
+}
+
 static int
 run_threads(kdump_ctx_t *ctx, unsigned long nthreads, unsigned long cache_size)
 {
@@ -81,9 +353,12 @@ run_threads(kdump_ctx_t *ctx, unsigned long nthreads, unsigned long cache_size)
 		pthread_t id;
 		kdump_ctx_t *ctx;
 	} tinfo[nthreads];
+	struct timespec start, end;
 	pthread_attr_t attr;
 	kdump_attr_t val;
+	kdump_num_t evictions;
 	kdump_status res;
+	double elapsed;
 	unsigned i;
 	int rc;
 
@@ -98,12 +373,122 @@ run_threads(kdump_ctx_t *ctx, unsigned long nthreads, unsigned long cache_size)
 		}
 	}
 
+	if (cache_max_bytes) {
+		val.type = KDUMP_NUMBER;
+		val.val.number = cache_max_bytes;
+		res = kdump_set_attr(ctx, "cache.max_bytes", &val);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set cache limit: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+	}
+
+	if (hugepages) {
+		val.type = KDUMP_NUMBER;
+		val.val.number = 1;
+		res = kdump_set_attr(ctx, "cache.hugepages", &val);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set huge page mode: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+		res = kdump_get_attr(ctx, "cache.data_mode", &val);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot get cache data mode: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+		printf("Cache data mode: %s\n", val.val.string);
+	}
+
+	if (numa) {
+		val.type = KDUMP_NUMBER;
+		val.val.number = 1;
+		res = kdump_set_attr(ctx, "cache.numa.enabled", &val);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set NUMA mode: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+		res = kdump_get_attr(ctx, "cache.numa.nodes", &val);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot get cache partitions: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+		printf("Cache partitions: %llu\n",
+		       (unsigned long long) val.val.number);
+	}
+
+	if (cache_policy) {
+		val.type = KDUMP_STRING;
+		val.val.string = cache_policy;
+		res = kdump_set_attr(ctx, "cache.policy", &val);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set cache policy: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+	}
+
+	if (cache_wait) {
+		val.type = KDUMP_NUMBER;
+		val.val.number = 1;
+		res = kdump_set_attr(ctx, "cache.wait", &val);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set cache wait mode: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+	}
+
+	if (l1_pages >= 0) {
+		val.type = KDUMP_NUMBER;
+		val.val.number = l1_pages;
+		res = kdump_set_attr(ctx, "cache.l1.pages", &val);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set private cache size: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+	}
+
+	if (ra_window >= 0) {
+		val.type = KDUMP_NUMBER;
+		val.val.number = ra_window;
+		res = kdump_set_attr(ctx, "cache.readahead", &val);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set read-ahead window: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+	}
+
+	if (prefetch_threads) {
+		val.type = KDUMP_NUMBER;
+		val.val.number = prefetch_threads;
+		res = kdump_set_attr(ctx, "cache.prefetch_threads", &val);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot start prefetch threads: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+	}
+
+	if (npinned && pin_pages(ctx) != TEST_OK)
+		return TEST_ERR;
+
+	if (scan && get_evictions(ctx, &evictions) != TEST_OK)
+		return TEST_ERR;
+
 	res = pthread_attr_init(&attr);
 	if (res) {
 		fprintf(stderr, "pthread_attr_init: %s\n", strerror(res));
 		return TEST_ERR;
 	}
 
+	clock_gettime(CLOCK_MONOTONIC, &start);
 	for (i = 0; i < nthreads; ++i) {
 		tinfo[i].ctx = kdump_clone(ctx, 0);
 		if (!tinfo[i].ctx) {
@@ -111,6 +496,8 @@ run_threads(kdump_ctx_t *ctx, unsigned long nthreads, unsigned long cache_size)
 				strerror(res));
 			return TEST_ERR;
 		}
+		if (scan)
+			kdump_set_read_flags(tinfo[i].ctx, KDUMP_READ_SCAN);
 
 		res = pthread_create(&tinfo[i].id, &attr, run_reads,
 				     tinfo[i].ctx);
@@ -135,6 +522,54 @@ run_threads(kdump_ctx_t *ctx, unsigned long nthreads, unsigned long cache_size)
 		}
 		kdump_free(tinfo[i].ctx);
 	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	elapsed = (end.tv_sec - start.tv_sec) +
+		(end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("%lu threads: %lu reads in %.3f s (%.0f reads/s)\n",
+	       nthreads, nthreads * niter, elapsed,
+	       elapsed > 0 ? nthreads * niter / elapsed : 0.0);
+
+	if (rc == TEST_OK && npinned)
+		rc = check_pinned(ctx);
+
+	if (rc == TEST_OK && l1_pages >= 0) {
+		kdump_num_t hits, misses;
+		if (kdump_get_number_attr(ctx, "cache.l1.hits",
+					  &hits) != KDUMP_OK ||
+		    kdump_get_number_attr(ctx, "cache.l1.misses",
+					  &misses) != KDUMP_OK) {
+			fprintf(stderr, "Cannot get private cache stats: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+		printf("Private cache: %llu hits, %llu misses\n",
+		       (unsigned long long) hits,
+		       (unsigned long long) misses);
+	}
+
+	if (rc == TEST_OK && numa) {
+		kdump_num_t hits;
+		if (kdump_get_number_attr(ctx, "cache.numa.remote_hits",
+					  &hits) != KDUMP_OK) {
+			fprintf(stderr, "Cannot get remote hits: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+		printf("Remote partition hits: %llu\n",
+		       (unsigned long long) hits);
+	}
+
+	if (rc == TEST_OK && scan) {
+		kdump_num_t before = evictions;
+		if (get_evictions(ctx, &evictions) != TEST_OK)
+			return TEST_ERR;
+		if (evictions != before) {
+			fprintf(stderr, "Scan caused %llu evictions\n",
+				(unsigned long long) (evictions - before));
+			rc = TEST_FAIL;
+		}
+	}
 
 	return rc;
 }
@@ -152,6 +587,51 @@ run_threads_fd(int fd, unsigned long nthreads, unsigned long cache_size)
 		return TEST_ERR;
 	}
 
+	/* The persistent cache is opened together with the dump. */
+	if (pcache_path) {
+		res = kdump_set_string_attr(ctx, "cache.persistent.path",
+					    pcache_path);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set persistent cache: %s\n",
+				kdump_get_err(ctx));
+			kdump_free(ctx);
+			return TEST_ERR;
+		}
+	}
+
+	/* The file mapping mode is used when the dump is opened. */
+	if (map_file >= 0) {
+		res = kdump_set_number_attr(ctx, "fcache.map_file", map_file);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set file mapping mode: %s\n",
+				kdump_get_err(ctx));
+			kdump_free(ctx);
+			return TEST_ERR;
+		}
+	}
+
+	/* File cache regions are also configured when the dump is opened. */
+	res = KDUMP_OK;
+	if (fcache_order >= 0)
+		res = kdump_set_number_attr(ctx, "fcache.mmap.order",
+					    fcache_order);
+	if (res == KDUMP_OK && fcache_windows)
+		res = kdump_set_number_attr(ctx, "fcache.mmap.windows",
+					    fcache_windows);
+	if (res == KDUMP_OK && fcache_adaptive)
+		res = kdump_set_number_attr(ctx, "fcache.mmap.adaptive", 1);
+	if (res == KDUMP_OK && use_uring)
+		res = kdump_set_number_attr(ctx, "fcache.io_uring", 1);
+	if (res == KDUMP_OK && fcache_advice)
+		res = kdump_set_string_attr(ctx, "fcache.advice",
+					    fcache_advice);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot set file cache regions: %s\n",
+			kdump_get_err(ctx));
+		kdump_free(ctx);
+		return TEST_ERR;
+	}
+
 	res = kdump_set_number_attr(ctx, KDUMP_ATTR_FILE_FD, fd);
 	if (res != KDUMP_OK) {
 		fprintf(stderr, "Cannot open dump: %s\n", kdump_get_err(ctx));
@@ -159,6 +639,72 @@ run_threads_fd(int fd, unsigned long nthreads, unsigned long cache_size)
 	} else
 		rc = run_threads(ctx, nthreads, cache_size);
 
+	if (rc == TEST_OK && pcache_path) {
+		kdump_num_t hits, misses;
+		if (kdump_get_number_attr(ctx, "cache.persistent.hits",
+					  &hits) != KDUMP_OK ||
+		    kdump_get_number_attr(ctx, "cache.persistent.misses",
+					  &misses) != KDUMP_OK) {
+			fprintf(stderr, "Cannot get cache stats: %s\n",
+				kdump_get_err(ctx));
+			rc = TEST_ERR;
+		} else
+			printf("Persistent cache: %llu hits, %llu misses\n",
+			       (unsigned long long) hits,
+			       (unsigned long long) misses);
+	}
+
+	if (rc == TEST_OK && use_uring) {
+		const char *backend;
+		if (kdump_get_string_attr(ctx, "fcache.backend",
+					  &backend) != KDUMP_OK) {
+			fprintf(stderr, "Cannot get file cache backend: %s\n",
+				kdump_get_err(ctx));
+			rc = TEST_ERR;
+		} else
+			printf("File cache backend: %s\n", backend);
+	}
+
+	if (rc == TEST_OK && fcache_advice) {
+		kdump_num_t loads, hits;
+		const char *advice;
+		if (kdump_get_number_attr(ctx, "cache.readahead_loads",
+					  &loads) != KDUMP_OK ||
+		    kdump_get_number_attr(ctx, "cache.readahead_hits",
+					  &hits) != KDUMP_OK ||
+		    kdump_get_string_attr(ctx, "fcache.current_advice",
+					  &advice) != KDUMP_OK) {
+			fprintf(stderr, "Cannot get read-ahead stats: %s\n",
+				kdump_get_err(ctx));
+			rc = TEST_ERR;
+		} else {
+			printf("Read-ahead: %llu loads, %llu hits\n",
+			       (unsigned long long) loads,
+			       (unsigned long long) hits);
+			printf("File cache advice: %s\n", advice);
+		}
+	}
+
+	if (rc == TEST_OK && map_file >= 0) {
+		kdump_num_t mapped, maps, unmaps;
+		if (kdump_get_number_attr(ctx, "fcache.bytes_mapped",
+					  &mapped) != KDUMP_OK ||
+		    kdump_get_number_attr(ctx, "fcache.mmap.maps",
+					  &maps) != KDUMP_OK ||
+		    kdump_get_number_attr(ctx, "fcache.mmap.unmaps",
+					  &unmaps) != KDUMP_OK) {
+			fprintf(stderr, "Cannot get mapped bytes: %s\n",
+				kdump_get_err(ctx));
+			rc = TEST_ERR;
+		} else {
+			printf("Mapped bytes: %llu\n",
+			       (unsigned long long) mapped);
+			printf("Region maps: %llu, unmaps: %llu\n",
+			       (unsigned long long) maps,
+			       (unsigned long long) unmaps);
+		}
+	}
+
 	kdump_free(ctx);
 	return rc;
 }
@@ -170,10 +716,33 @@ usage(const char *name)
 		"Usage: %s [<options>] <dump> <base-pfn> <num-pages>\n"
 		"\n"
 		"Options:\n"
+		"  -a              Enlarge file cache regions for sequential reads\n"
+		"  -A advice       File cache access pattern advice\n"
+		"  -b batch-size   Read pages in batches\n"
+		"  -c pages        Read this many pages at once\n"
+		"  -d              Check that each byte of a page equals its PFN\n"
+		"  -e policy       Cache replacement policy\n"
+		"  -f              Prefetch all pages before reading\n"
+		"  -H              Back cache data with huge pages\n"
 		"  -i iterations   Number of reads per thread (default: %u)\n"
+		"  -k pages        Pin this many pages at the start of the range\n"
+		"  -l pages        Size of the private page cache\n"
+		"  -m max-bytes    Maximum cache size in bytes\n"
+		"  -M mode         Map the whole file (1) or in regions (0)\n"
 		"  -n num-threads  Number of threads (default: %u)\n"
+		"  -o order        Page order of file cache regions\n"
+		"  -N              Partition the cache by NUMA nodes\n"
+		"  -p num-threads  Number of prefetch threads\n"
+		"  -P path         Persistent cache file\n"
+		"  -q              Read pages sequentially\n"
+		"  -r pages        Read-ahead window\n"
 		"  -s cache-size   Cache size\n"
-		"  -t timeout      Maximum execution time in seconds\n",
+		"  -S              Read without adding pages to the cache\n"
+		"  -t timeout      Maximum execution time in seconds\n"
+		"  -u              Read the dump file with io_uring\n"
+		"  -w              Wait for busy cache entries\n"
+		"  -W windows      Number of file cache regions\n"
+		"  -z              Access pages without copying\n",
 		name, DEFITER, DEFTHREADS);
 }
 
@@ -190,8 +759,48 @@ main(int argc, char **argv)
 	nthreads = DEFTHREADS;
 	cache_size = 0;
 	timeout = 0;
-	while ((opt = getopt(argc, argv, "hi:n:s:t:")) != -1) {
+	while ((opt = getopt(argc, argv, "aA:b:c:de:fHhi:k:l:m:M:n:No:p:P:qr:s:St:uwW:z")) != -1) {
 		switch (opt) {
+		case 'a':
+			fcache_adaptive = 1;
+			break;
+
+		case 'A':
+			fcache_advice = optarg;
+			break;
+
+		case 'b':
+			batch = strtoul(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'c':
+			span = strtoul(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'd':
+			check_data = 1;
+			break;
+
+		case 'e':
+			cache_policy = optarg;
+			break;
+
+		case 'f':
+			prefetch = 1;
+			break;
+
+		case 'H':
+			hugepages = 1;
+			break;
+
 		case 'i':
 			niter = strtoul(optarg, &p, 0);
 			if (*p) {
@@ -200,6 +809,54 @@ main(int argc, char **argv)
 			}
 			break;
 
+		case 'k':
+			npinned = strtoul(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'l':
+			l1_pages = strtol(optarg, &p, 0);
+			if (*p || l1_pages < 0) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'm':
+			cache_max_bytes = strtoull(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'M':
+			map_file = strtol(optarg, &p, 0);
+			if (*p || map_file < 0) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'o':
+			fcache_order = strtol(optarg, &p, 0);
+			if (*p || fcache_order < 0) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'W':
+			fcache_windows = strtoul(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
 		case 'n':
 			nthreads = strtoul(optarg, &p, 0);
 			if (*p) {
@@ -208,6 +865,34 @@ main(int argc, char **argv)
 			}
 			break;
 
+		case 'N':
+			numa = 1;
+			break;
+
+		case 'p':
+			prefetch_threads = strtoul(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'P':
+			pcache_path = optarg;
+			break;
+
+		case 'q':
+			sequential = 1;
+			break;
+
+		case 'r':
+			ra_window = strtol(optarg, &p, 0);
+			if (*p || ra_window < 0) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
 		case 's':
 			cache_size = strtoul(optarg, &p, 0);
 			if (*p) {
@@ -216,6 +901,10 @@ main(int argc, char **argv)
 			}
 			break;
 
+		case 'S':
+			scan = 1;
+			break;
+
 		case 't':
 			timeout = strtoul(optarg, &p, 0);
 			if (*p) {
@@ -224,6 +913,17 @@ main(int argc, char **argv)
 			}
 			break;
 
+		case 'u':
+			use_uring = 1;
+			break;
+
+		case 'w':
+			cache_wait = 1;
+			break;
+
+		case 'z':
+			zerocopy = 1;
+			break;
 
 		case 'h':
 		default:
@@ -247,6 +947,11 @@ main(int argc, char **argv)
 		fprintf(stderr, "Invalid number: %s\n", argv[optind+2]);
 		return TEST_ERR;
 	}
+	if (span > npages) {
+		fprintf(stderr, "Cannot read %lu pages out of %lu\n",
+			span, npages);
+		return TEST_ERR;
+	}
 
 	fd = open(argv[optind], O_RDONLY);
 	if (fd < 0) {
@@ -43,6 +43,7 @@
 static unsigned long long rootpgt1, rootpgt2;
 static unsigned long long addr = 0;
 static unsigned long len = sizeof(long);
+static long xlat_pages = -1;
 
 static inline int
 endofline(unsigned long long addr)
@@ -185,6 +186,17 @@ read_fd(int fd)
 		return TEST_ERR;
 	}
 
+	if (xlat_pages >= 0) {
+		res = kdump_set_number_attr(ctx, "cache.xlat.pages",
+					    xlat_pages);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set read cache size: %s\n",
+				kdump_get_err(ctx));
+			kdump_free(ctx);
+			return TEST_ERR;
+		}
+	}
+
 	res = kdump_set_number_attr(ctx, KDUMP_ATTR_FILE_FD, fd);
 	if (res != KDUMP_OK) {
 		fprintf(stderr, "Cannot open dump: %s\n", kdump_get_err(ctx));
@@ -206,7 +218,8 @@ usage(const char *name)
 		"  -1 paddr   First root page table\n"
 		"  -2 paddr   Second root page table\n"
 		"  -a addr    Read start address (default: 0)\n"
-		"  -l len     Number of bytes to read (default: %lu)\n",
+		"  -l len     Number of bytes to read (default: %lu)\n"
+		"  -p pages   Address translation read cache pages\n",
 		name, len);
 }
 
@@ -217,7 +230,7 @@ main(int argc, char **argv)
 	int fd;
 	int rc;
 
-	while ((opt = getopt(argc, argv, "h1:2:a:l:")) != -1) {
+	while ((opt = getopt(argc, argv, "h1:2:a:l:p:")) != -1) {
 		char *p;
 		switch (opt) {
 		case '1':
@@ -252,6 +265,14 @@ main(int argc, char **argv)
 			}
 			break;
 
+		case 'p':
+			xlat_pages = strtol(optarg, &p, 0);
+			if (*p || xlat_pages < 0) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
 		case 'h':
 		default:
 			usage(argv[0]);